@@ -1,15 +1,91 @@
 #pragma once
 #include <chrono>
+#include <cstdint>
+#include <ctime>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+// Nanoseconds of CLOCK_MONOTONIC_RAW, which NTP never slews; steady_clock
+// where that clock does not exist.
+inline std::uint64_t monotonic_ns() {
+#if defined(CLOCK_MONOTONIC_RAW)
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+  return static_cast<std::uint64_t>(ts.tv_sec) * 1000000000U +
+         static_cast<std::uint64_t>(ts.tv_nsec);
+#else
+  return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+#endif
+}
+
+// Time stamp counter for timing single short calls: reading it costs a few
+// cycles where clock_gettime costs tens of nanoseconds. The tick rate is
+// measured against monotonic_ns() once, on first use. Without an invariant
+// TSC (or off x86) ticks are monotonic_ns() nanoseconds.
+class TscClock {
+public:
+  static std::uint64_t now() {
+#if defined(__x86_64__) || defined(__i386__)
+    if (calibration().invariant) {
+      // Keep the read from being hoisted above the code being timed.
+      _mm_lfence();
+      return __rdtsc();
+    }
+#endif
+    return monotonic_ns();
+  }
+
+  static double ns_per_tick() { return calibration().ns_per_tick; }
+
+  static std::uint64_t to_ns(std::uint64_t ticks) {
+    return static_cast<std::uint64_t>(static_cast<double>(ticks) * ns_per_tick() + 0.5);
+  }
+
+  static bool uses_tsc() { return calibration().invariant; }
+
+private:
+  struct Calibration {
+    bool invariant = false;
+    double ns_per_tick = 1.0;
+  };
+
+  static const Calibration &calibration() {
+    static const Calibration c = calibrate();
+    return c;
+  }
+
+  static Calibration calibrate() {
+    Calibration c;
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (__get_cpuid(0x80000007U, &eax, &ebx, &ecx, &edx) && (edx & (1U << 8U))) {
+      c.invariant = true;
+      const std::uint64_t ns0 = monotonic_ns();
+      const std::uint64_t tsc0 = __rdtsc();
+      std::uint64_t ns1 = ns0;
+      while (ns1 - ns0 < 20000000U) {
+        ns1 = monotonic_ns();
+      }
+      const std::uint64_t tsc1 = __rdtsc();
+      c.ns_per_tick = static_cast<double>(ns1 - ns0) / static_cast<double>(tsc1 - tsc0);
+    }
+#endif
+    return c;
+  }
+};
+
 class Timer {
 private:
-  std::chrono::time_point<std::chrono::high_resolution_clock> start;
+  std::uint64_t start;
 
 public:
-  Timer() : start{std::chrono::high_resolution_clock::now()} {}
-  void reset() { start = std::chrono::high_resolution_clock::now(); }
-  double elapsed() const {
-    return std::chrono::duration<double>(
-               std::chrono::high_resolution_clock::now() - start)
-        .count();
-  }
+  Timer() : start{monotonic_ns()} {}
+  void reset() { start = monotonic_ns(); }
+  double elapsed() const { return static_cast<double>(elapsed_ns()) * 1e-9; }
+  std::uint64_t elapsed_ns() const { return monotonic_ns() - start; }
 };
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
+
+struct AsyncReadOptions {
+  unsigned queue_depth = 32;
+  std::size_t buffer_size = std::size_t{1} << 20U;
+  // Use the pread fallback even where io_uring works.
+  bool force_pread = false;
+};
+
+// Reads whole files for bulk hashing with up to queue_depth reads in flight.
+// On Linux the reads go through an io_uring into a pool of queue_depth
+// registered buffers of buffer_size bytes (larger files get their own
+// allocation). Each finished file is handed to the consumer on the shared
+// ThreadPool while the next reads are already queued, and its buffer goes
+// back to the pool when the consumer returns. Without io_uring (another
+// platform, or a kernel that refuses io_uring_setup) the same interface
+// runs blocking preads on the pool, queue_depth files at a time.
+class AsyncFileReader {
+public:
+  // Called concurrently for different files; data is valid for the call only.
+  using Consumer = std::function<void(std::size_t index, std::string_view data)>;
+
+  explicit AsyncFileReader(AsyncReadOptions options = {});
+  AsyncFileReader(const AsyncFileReader &) = delete;
+  AsyncFileReader &operator=(const AsyncFileReader &) = delete;
+  ~AsyncFileReader();
+
+  // One call at a time per reader. Throws std::filesystem::filesystem_error
+  // for a file that cannot be opened or read; that, or the first exception a
+  // consumer threw, is rethrown once the reads in flight have drained.
+  void read_all(std::span<const std::filesystem::path> files,
+                const Consumer &consume);
+
+  // "io_uring" or "pread".
+  [[nodiscard]] const char *backend() const;
+
+private:
+  struct Ring;
+
+  void read_all_pread(std::span<const std::filesystem::path> files,
+                      const Consumer &consume);
+  void read_all_ring(std::span<const std::filesystem::path> files,
+                     const Consumer &consume);
+
+  AsyncReadOptions options;
+  std::vector<char> buffers;
+  std::unique_ptr<Ring> ring;
+};
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <iosfwd>
+#include <span>
+#include <string>
+#include <vector>
+
+// Repeated timings of one hasher at one message size. Each sample is the
+// mean ns per call over one repetition.
+struct BenchResult {
+  std::string hasher;
+  std::size_t size = 0;
+  std::vector<double> samples_ns;
+
+  // Median of the samples.
+  [[nodiscard]] double ns_per_op() const;
+  [[nodiscard]] double stddev() const;
+};
+
+struct BenchRun {
+  std::string commit;
+  std::vector<BenchResult> results;
+};
+
+// {"commit": ..., "results": [{"hasher", "size", "ns_per_op", "stddev",
+// "samples"}, ...]}. ns_per_op and stddev are written for readers; only
+// the samples are read back.
+void write_bench_json(std::ostream &os, const BenchRun &run);
+// Throws std::runtime_error on malformed input or a result without samples.
+[[nodiscard]] BenchRun read_bench_json(std::istream &is);
+
+// One-sided Mann-Whitney U test of "current tends to be larger than
+// baseline", with average ranks for ties and the normal approximation
+// (tie-corrected variance, continuity correction).
+struct MannWhitney {
+  double u = 0.0;
+  double z = 0.0;
+  double p_value = 1.0;
+};
+[[nodiscard]] MannWhitney mann_whitney_greater(std::span<const double> current,
+                                               std::span<const double> baseline);
+
+struct BenchComparison {
+  std::string hasher;
+  std::size_t size = 0;
+  double baseline_ns = 0.0;
+  double current_ns = 0.0;
+  // current / baseline - 1 on the medians.
+  double change = 0.0;
+  double p_value = 1.0;
+  // Significant at alpha and slower by more than min_slowdown.
+  bool regression = false;
+};
+
+// Every (hasher, size) present in both runs, in the current run's order.
+[[nodiscard]] std::vector<BenchComparison>
+compare_runs(const BenchRun &baseline, const BenchRun &current, double alpha,
+             double min_slowdown);
\ No newline at end of file
@@ -1,9 +1,83 @@
 #pragma once
 #include "IHasher.h"
+#include "ai_hasher_detail.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
 #include <string>
+#include <string_view>
+#include <vector>
 
 class AIHasher final: public IHasher {
 public:
   AIHasher() {}
+  // thread_count caps the ThreadPool workers of the parallel absorb (0 uses
+  // the whole pool); digests do not depend on it.
+  explicit AIHasher(unsigned thread_count) : threads(thread_count) {}
+  // Keyed mode: the key is absorbed into a private initial block that
+  // replaces the public seed.
+  explicit AIHasher(std::string_view key, unsigned thread_count = 0);
   virtual std::string hash256bit(const std::string &input) const override final;
-};
\ No newline at end of file
+  virtual std::unique_ptr<IHasher> keyed(std::string_view key) const override final;
+
+  // First N bytes of the digest (the bytes hash256bit hex-encodes) without
+  // hex encoding or further squeezing. Instantiated for N = 8, 16 and 32.
+  template <std::size_t N>
+  [[nodiscard]] std::array<std::uint8_t, N> digest(std::string_view input) const;
+
+  // Extendable output. Bytes come 32 at a time from the absorbed state and a
+  // block counter, so a shorter read is a prefix of a longer one; the first
+  // 32 bytes equal digest<32>().
+  class Reader {
+  public:
+    void read(std::span<std::uint8_t> out);
+
+  private:
+    friend class AIHasher;
+    explicit Reader(const ai_hasher_detail::Block &absorbed) : state(absorbed) {}
+
+    ai_hasher_detail::Block state;
+    ai_hasher_detail::Output buffer{};
+    std::size_t position = ai_hasher_detail::kOutputBlockSize;
+    std::uint64_t counter = 0;
+  };
+  [[nodiscard]] Reader xof(std::string_view input) const;
+  [[nodiscard]] std::vector<std::uint8_t> hash_bytes(std::string_view input,
+                                                     std::size_t length) const;
+
+  // Compile-time digest of a constant: the same bytes as digest<32>() of
+  // the unkeyed hasher.
+  static constexpr std::array<std::uint8_t, 32>
+  constant_digest(std::string_view input) {
+    ai_hasher_detail::Block block = ai_hasher_detail::kSeed;
+    ai_hasher_detail::absorb_sequential(input, block);
+    return ai_hasher_detail::finalize(block);
+  }
+  // The first eight digest bytes as a little-endian integer, for switching
+  // on strings: switch (AIHasher::key64(name)) { case "verify"_ai64: ... }
+  static constexpr std::uint64_t key64(std::string_view input) {
+    const auto digest = constant_digest(input);
+    std::uint64_t key = 0;
+    for (std::size_t b = 0; b < 8; ++b) {
+      key |= static_cast<std::uint64_t>(digest[b]) << (b * 8U);
+    }
+    return key;
+  }
+
+private:
+  ai_hasher_detail::Block absorbed_state(std::string_view input) const;
+
+  unsigned threads = 0;
+  // Unset for the unkeyed hasher.
+  std::optional<ai_hasher_detail::Block> key_seed;
+};
+
+consteval std::uint64_t operator""_ai64(const char *text, std::size_t size) {
+  return AIHasher::key64(std::string_view(text, size));
+}
+
+extern template std::array<std::uint8_t, 8> AIHasher::digest<8>(std::string_view) const;
+extern template std::array<std::uint8_t, 16> AIHasher::digest<16>(std::string_view) const;
+extern template std::array<std::uint8_t, 32> AIHasher::digest<32>(std::string_view) const;
\ No newline at end of file
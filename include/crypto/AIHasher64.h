@@ -0,0 +1,94 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Reduced-round 64-bit AIHasher for in-memory hash tables. It is not a
+// cryptographic hash and not a truncation of AIHasher: it keeps AIHasher's
+// seed and rotation schedule but absorbs whole 64-bit words into four lanes
+// and finishes with a short multiply/xorshift avalanche instead of the
+// byte-wise mixing stages. Usable as the Hash of unordered containers, with
+// heterogeneous string_view lookup.
+struct AIHasher64 {
+  using is_transparent = void;
+
+  [[nodiscard]] static constexpr std::uint64_t
+  hash(std::string_view input, std::uint64_t seed = 0) noexcept;
+
+  std::size_t operator()(std::string_view input) const noexcept {
+    return static_cast<std::size_t>(hash(input));
+  }
+
+private:
+  // First 32 bytes of AIHasher's kSeed, read as little-endian words.
+  static constexpr std::array<std::uint64_t, 4> kLanes = {
+      0x8ef05dc4a933b11dULL, 0xfe71452fdb6a9327ULL, 0x42e5169d3a0c548bULL,
+      0x04c25a971e68f7acULL};
+  static constexpr std::array<unsigned, 4> kRotations = {11U, 23U, 7U, 19U};
+  static constexpr std::uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+  static constexpr std::uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+  static constexpr std::uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+
+  static constexpr std::uint64_t rotl(std::uint64_t value, unsigned shift) {
+    return (value << shift) | (value >> ((64U - shift) & 63U));
+  }
+
+  // Compilers turn this into a single unaligned load.
+  static constexpr std::uint64_t load(std::string_view input, std::size_t at,
+                                      std::size_t count = 8) {
+    std::uint64_t word = 0;
+    for (std::size_t b = 0; b < count; ++b) {
+      word |= static_cast<std::uint64_t>(static_cast<unsigned char>(input[at + b]))
+              << (b * 8U);
+    }
+    return word;
+  }
+
+  static constexpr std::uint64_t round(std::uint64_t lane, std::uint64_t word,
+                                       unsigned shift) {
+    return rotl(lane + word * kPrime2, shift) * kPrime1;
+  }
+
+  static constexpr std::uint64_t avalanche(std::uint64_t h) {
+    h ^= h >> 33U;
+    h *= kPrime2;
+    h ^= h >> 29U;
+    h *= kPrime3;
+    h ^= h >> 32U;
+    return h;
+  }
+};
+
+constexpr std::uint64_t AIHasher64::hash(std::string_view input,
+                                         std::uint64_t seed) noexcept {
+  const std::size_t size = input.size();
+  std::size_t at = 0;
+  std::uint64_t h;
+  if (size >= 32) {
+    std::array<std::uint64_t, 4> lanes = {kLanes[0] ^ seed, kLanes[1] ^ seed,
+                                          kLanes[2] ^ seed, kLanes[3] ^ seed};
+    for (; at + 32 <= size; at += 32) {
+      for (std::size_t l = 0; l < 4; ++l) {
+        lanes[l] = round(lanes[l], load(input, at + l * 8), kRotations[l]);
+      }
+    }
+    h = rotl(lanes[0], 1U) + rotl(lanes[1], 7U) + rotl(lanes[2], 12U) +
+        rotl(lanes[3], 18U);
+    for (const std::uint64_t lane : lanes) {
+      h = (h ^ round(0, lane, 31U)) * kPrime1 + kPrime3;
+    }
+  } else {
+    h = kLanes[0] ^ seed ^ kPrime3;
+  }
+
+  h += static_cast<std::uint64_t>(size);
+  for (; at + 8 <= size; at += 8) {
+    h = rotl(h ^ round(0, load(input, at), 31U), 27U) * kPrime1 + kPrime3;
+  }
+  if (at < size) {
+    h ^= load(input, at, size - at) * kPrime1;
+    h = rotl(h, 23U) * kPrime2;
+  }
+  return avalanche(h);
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+#include "IHasher.h"
+#include "ai_hasher_detail.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Tree mode of AIHasher (version 1). The input is cut into kLeafSize leaves,
+// each compressed independently with the AIHasher stages; parents combine
+// two child digests. Leaves pair up left to right at every level, an odd
+// trailing node moving up unchanged, so the left subtree of every parent
+// holds a power-of-two number of leaves. Node headers carry the version,
+// a leaf/parent/root flag and the leaf index, so digests differ from
+// AIHasher and from any other tree version.
+class AITreeHasher final : public IHasher {
+public:
+  using Digest = std::array<std::uint8_t, 32>;
+
+  static constexpr std::uint8_t kVersion = 1;
+  static constexpr std::size_t kLeafSize = 16 * 1024;
+
+  explicit AITreeHasher(unsigned thread_count = 0) : threads(thread_count) {}
+  // Keyed tree: every node starts from AIHasher's keyed initial block.
+  explicit AITreeHasher(std::string_view key, unsigned thread_count = 0);
+  virtual std::string hash256bit(const std::string &input) const override final;
+  virtual std::unique_ptr<IHasher> keyed(std::string_view key) const override final;
+  [[nodiscard]] Digest digest(std::string_view input) const;
+
+  // Incremental hashing of data that arrives in pieces; produces the same
+  // digest as hashing the concatenation in one call. Stream and Incremental
+  // are unkeyed.
+  class Stream {
+  public:
+    void update(std::string_view data);
+    [[nodiscard]] Digest finalize() const;
+
+  private:
+    std::string pending;
+    std::vector<Digest> stack;
+    std::uint64_t leaves_done = 0;
+  };
+
+  // Keeps every tree node so that rewriting a byte range only re-hashes the
+  // touched leaves and their paths to the root.
+  class Incremental {
+  public:
+    explicit Incremental(std::string_view data, unsigned thread_count = 0);
+    // data must be the full, already modified buffer (same length as before).
+    void update(std::string_view data, std::size_t offset, std::size_t length);
+    [[nodiscard]] const Digest &root() const { return levels.back().front(); }
+
+  private:
+    void rebuild_parent(std::size_t level, std::size_t index);
+
+    std::size_t size;
+    std::vector<std::vector<Digest>> levels;
+  };
+
+private:
+  unsigned threads;
+  // Initial block of every node; the public seed unless keyed.
+  ai_hasher_detail::Block seed = ai_hasher_detail::kSeed;
+};
\ No newline at end of file
@@ -1,9 +1,18 @@
 #pragma once
 #include "IHasher.h"
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <vector>
 
 class Hasher final: public IHasher {
 public:
   Hasher() {}
+  explicit Hasher(std::string_view key);
   virtual std::string hash256bit(const std::string &input) const override final;
+  virtual std::unique_ptr<IHasher> keyed(std::string_view key) const override final;
+
+private:
+  // Empty for the unkeyed hasher.
+  std::vector<uint8_t> key_seed;
 };
\ No newline at end of file
@@ -1,8 +1,28 @@
 #pragma once
+#include <memory>
+#include <span>
 #include <string>
+#include <string_view>
+#include <vector>
 
+// hash256bit() is const and callers hash on the thread pool with one shared
+// object, so implementations must not keep per-call state in the object or
+// in globals.
 class IHasher {
 public:
   virtual ~IHasher() = default;
   virtual std::string hash256bit(const std::string &input) const = 0;
+  virtual std::vector<std::string>
+  hash256bit_batch(std::span<const std::string> inputs) const {
+    std::vector<std::string> digests;
+    digests.reserve(inputs.size());
+    for (const auto &input : inputs) {
+      digests.push_back(hash256bit(input));
+    }
+    return digests;
+  }
+  // A hasher of the same kind keyed with key (replacing any key this one
+  // has). The key schedule is computed here, once; hashing a message with
+  // the returned object costs the same as unkeyed hashing.
+  virtual std::unique_ptr<IHasher> keyed(std::string_view key) const = 0;
 };
\ No newline at end of file
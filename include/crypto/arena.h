@@ -0,0 +1,160 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Fixed-size chunks that never move once allocated, so indices and element
+// addresses stay valid for the lifetime of the arena. Index lookup is a shift
+// and a mask.
+template <typename T, std::size_t ChunkShift = 10> class ChunkedArena {
+public:
+  static constexpr std::size_t kChunkSize = std::size_t{1} << ChunkShift;
+  static constexpr std::size_t kChunkMask = kChunkSize - 1U;
+
+  ChunkedArena() = default;
+  ChunkedArena(const ChunkedArena &) = delete;
+  ChunkedArena &operator=(const ChunkedArena &) = delete;
+  ChunkedArena(ChunkedArena &&other) noexcept
+      : chunks_(std::move(other.chunks_)), size_(std::exchange(other.size_, 0)) {}
+  ChunkedArena &operator=(ChunkedArena &&other) noexcept {
+    if (this != &other) {
+      clear();
+      chunks_ = std::move(other.chunks_);
+      size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+  }
+  ~ChunkedArena() { clear(); }
+
+  template <typename... Args> std::size_t emplace_back(Args &&...args) {
+    if ((size_ >> ChunkShift) == chunks_.size()) {
+      chunks_.push_back(allocator().allocate(kChunkSize));
+    }
+    std::construct_at(slot(size_), std::forward<Args>(args)...);
+    return size_++;
+  }
+
+  void pop_back() {
+    if (size_ == 0) {
+      throw std::out_of_range("pop_back on empty arena");
+    }
+    --size_;
+    std::destroy_at(slot(size_));
+    release_unused_chunks();
+  }
+
+  void clear() {
+    while (size_ > 0) {
+      --size_;
+      std::destroy_at(slot(size_));
+    }
+    release_unused_chunks();
+  }
+
+  [[nodiscard]] T &operator[](std::size_t index) { return *slot(index); }
+  [[nodiscard]] const T &operator[](std::size_t index) const {
+    return *slot(index);
+  }
+  [[nodiscard]] T &back() { return *slot(size_ - 1U); }
+  [[nodiscard]] const T &back() const { return *slot(size_ - 1U); }
+  [[nodiscard]] std::size_t size() const { return size_; }
+  [[nodiscard]] bool empty() const { return size_ == 0; }
+
+private:
+  static std::allocator<T> allocator() { return {}; }
+
+  T *slot(std::size_t index) const {
+    return chunks_[index >> ChunkShift] + (index & kChunkMask);
+  }
+
+  void release_unused_chunks() {
+    const std::size_t needed = (size_ + kChunkMask) >> ChunkShift;
+    while (chunks_.size() > needed) {
+      allocator().deallocate(chunks_.back(), kChunkSize);
+      chunks_.pop_back();
+    }
+  }
+
+  std::vector<T *> chunks_;
+  std::size_t size_ = 0;
+};
+
+// Stores variable-length runs of elements contiguously. A run never straddles
+// two chunks, so it can be handed out as a std::span that stays valid until the
+// run is popped. Runs are released in LIFO order.
+template <typename T, std::size_t MinChunkSize = 4096> class RunArena {
+public:
+  RunArena() = default;
+  RunArena(const RunArena &) = delete;
+  RunArena &operator=(const RunArena &) = delete;
+  RunArena(RunArena &&) noexcept = default;
+  RunArena &operator=(RunArena &&other) noexcept {
+    if (this != &other) {
+      clear();
+      chunks_ = std::move(other.chunks_);
+    }
+    return *this;
+  }
+  ~RunArena() { clear(); }
+
+  template <typename It> std::span<T> append(It first, It last) {
+    const auto count = static_cast<std::size_t>(std::distance(first, last));
+    if (chunks_.empty() || chunks_.back().capacity - chunks_.back().used < count) {
+      const std::size_t capacity = std::max(MinChunkSize, count);
+      chunks_.push_back(Chunk{allocator().allocate(capacity), 0, capacity});
+    }
+    Chunk &chunk = chunks_.back();
+    T *begin = chunk.data + chunk.used;
+    std::size_t constructed = 0;
+    try {
+      for (; first != last; ++first, ++constructed) {
+        std::construct_at(begin + constructed, *first);
+      }
+    } catch (...) {
+      std::destroy_n(begin, constructed);
+      throw;
+    }
+    chunk.used += count;
+    return {begin, count};
+  }
+
+  void pop_run(std::span<const T> run) {
+    if (run.empty()) {
+      return;
+    }
+    if (chunks_.empty() ||
+        run.data() + run.size() != chunks_.back().data + chunks_.back().used) {
+      throw std::logic_error("runs must be released in LIFO order");
+    }
+    Chunk &chunk = chunks_.back();
+    chunk.used -= run.size();
+    std::destroy_n(chunk.data + chunk.used, run.size());
+    if (chunk.used == 0) {
+      allocator().deallocate(chunk.data, chunk.capacity);
+      chunks_.pop_back();
+    }
+  }
+
+  void clear() {
+    for (auto &chunk : chunks_) {
+      std::destroy_n(chunk.data, chunk.used);
+      allocator().deallocate(chunk.data, chunk.capacity);
+    }
+    chunks_.clear();
+  }
+
+private:
+  struct Chunk {
+    T *data;
+    std::size_t used;
+    std::size_t capacity;
+  };
+
+  static std::allocator<T> allocator() { return {}; }
+
+  std::vector<Chunk> chunks_;
+};
@@ -1,7 +1,9 @@
 #pragma once
 #include "transaction.h"
 #include <ctime>
+#include <span>
 #include <string>
+#include <utility>
 #include <vector>
 
 class Block {
@@ -17,5 +19,19 @@ public:
         const std::string &previous_block_hash, int dificulty);
 
   std::string mine_block();
-  std::string to_hash();
+  std::string to_hash() const;
+
+  const std::string &previous_block_hash() const { return _previous_block_hash; }
+  const std::string &block_hash() const { return _block_hash; }
+  const std::vector<Transaction> &transactions() const { return _transactions; }
+  std::vector<Transaction> take_transactions() { return std::move(_transactions); }
+  std::time_t timestamp() const { return _timestamp; }
+  int nonce() const { return _nonce; }
+  int difficulty() const { return _dificulty; }
+
+  static std::string compute_hash(const std::string &previous_block_hash,
+                                  std::time_t timestamp, int nonce,
+                                  int dificulty,
+                                  std::span<const Transaction> transactions);
+  static bool meets_difficulty(const std::string &hash, int dificulty);
 };
\ No newline at end of file
@@ -1,14 +1,43 @@
 #pragma once
+#include "arena.h"
 #include "block.h"
-#include <list>
-#include <memory>
-#pragma once
-#include "block.h"
-#include <list>
+#include "transaction_verifier.h"
+#include "user.h"
+#include <cstddef>
+#include <ctime>
+#include <functional>
 #include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+struct BlockRecord {
+  std::string previous_block_hash;
+  std::string block_hash;
+  std::time_t timestamp;
+  int nonce;
+  int difficulty;
+  std::span<const Transaction> transactions;
+};
+
+struct ValidationResult {
+  bool valid = true;
+  std::optional<std::size_t> first_invalid_height;
+  std::string reason;
+};
+
+// Called with (validated block count, total block count).
+using ValidationProgress = std::function<void(std::size_t, std::size_t)>;
 
 class Blockchain {
-  std::list<std::unique_ptr<Block>> blocks;
+  ChunkedArena<BlockRecord> blocks;
+  RunArena<Transaction> transactions;
+  std::unordered_map<std::string_view, std::size_t> heights;
+  BalanceIndex balance_index;
+  TransactionVerifier verifier;
+  VerificationResult verification;
 
 public:
   Blockchain(const Blockchain&) = delete;
@@ -24,4 +53,26 @@ public:
   bool add_block(std::unique_ptr<Block> block);
   bool add_block(const Block& block);
   bool add_block(Block&& block);
+  // Removes the tip and rolls its transactions out of the balance index.
+  void pop_block();
+
+  [[nodiscard]] std::size_t size() const { return blocks.size(); }
+  [[nodiscard]] const BlockRecord& at(std::size_t height) const;
+  [[nodiscard]] const BlockRecord& tip() const { return blocks.back(); }
+  [[nodiscard]] std::optional<std::size_t> find(std::string_view block_hash) const;
+  [[nodiscard]] const BalanceIndex& balances() const { return balance_index; }
+  // Outcome and per-stage timings of the most recent transaction check.
+  [[nodiscard]] const VerificationResult& last_verification() const {
+    return verification;
+  }
+
+  [[nodiscard]] ValidationResult
+  validate(const ValidationProgress &progress = {},
+           unsigned thread_count = 0) const;
+
+private:
+  bool links_to_tip(const Block& block) const;
+  bool verify_transactions(const Block& block);
+  template <typename It>
+  void append(const Block& block, It first, It last);
 };
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+#include "IHasher.h"
+#include "chunker.h"
+#include "flat_string_map.h"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct ChunkRef {
+  std::string digest;
+  std::uint32_t size = 0;
+};
+
+// The chunks of one stored stream, in order.
+struct Manifest {
+  std::vector<ChunkRef> chunks;
+  std::uint64_t size = 0;
+};
+
+struct PutStats {
+  std::size_t chunks = 0;
+  std::size_t new_chunks = 0;
+  std::uint64_t bytes = 0;
+  std::uint64_t new_bytes = 0;
+};
+
+// Local content-addressed chunk store. Streams are cut with Chunker, every
+// chunk is named by its digest under the selected hasher, and a chunk is
+// written once however many streams contain it: root/objects/ab/cdef... for
+// digest "abcdef...". The hasher name is recorded in root/hasher and a store
+// cannot be reopened with a different one. Objects are written to a
+// temporary name and renamed, so a crash never leaves a partial chunk
+// behind a valid name. Chunks are hashed on the thread pool, which relies on
+// the hasher being safe to call from several threads at once.
+class ChunkStore {
+public:
+  explicit ChunkStore(std::filesystem::path root, std::string_view hasher_name = "ai",
+                      ChunkerParams params = {});
+
+  Manifest put(std::string_view data, PutStats *stats = nullptr);
+  Manifest put(std::istream &input, PutStats *stats = nullptr);
+
+  // Writes the stream back out, checking every chunk against its digest.
+  void restore(const Manifest &manifest, std::ostream &out) const;
+  [[nodiscard]] std::string read_chunk(const ChunkRef &chunk) const;
+
+  [[nodiscard]] bool contains(std::string_view digest) const {
+    return index.contains(digest);
+  }
+  [[nodiscard]] std::size_t chunk_count() const { return index.size(); }
+  [[nodiscard]] const Chunker &chunker() const { return cutter; }
+
+private:
+  void put_chunks(std::string_view data, const std::vector<std::size_t> &lengths,
+                  Manifest &manifest, PutStats &stats);
+  [[nodiscard]] std::filesystem::path object_path(std::string_view digest) const;
+
+  std::filesystem::path root;
+  std::unique_ptr<IHasher> hasher;
+  Chunker cutter;
+  // Digest -> chunk size of every object on disk.
+  FlatStringMap<std::uint32_t> index;
+};
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+#include "AIHasher64.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+struct ChunkerParams {
+  std::size_t min_size = 2 * 1024;
+  std::size_t avg_size = 8 * 1024;
+  std::size_t max_size = 64 * 1024;
+};
+
+// Content-defined chunking in the FastCDC style: a Gear rolling hash
+// (fp = (fp << 1) + gear[byte]) is tested against a mask after every byte
+// past min_size. A stricter mask is used up to avg_size and a looser one
+// after it, which pulls chunk sizes towards the average; max_size forces a
+// cut. Because the fingerprint only depends on the last 64 bytes, an edit
+// moves the boundaries around it and nowhere else.
+class Chunker {
+public:
+  explicit Chunker(ChunkerParams params = {});
+
+  // Length of the chunk starting at data.begin(). Input shorter than
+  // max_size may come back whole, so a streaming caller keeps max_size
+  // bytes buffered until the end of its input.
+  [[nodiscard]] std::size_t cut(std::string_view data) const;
+  [[nodiscard]] std::vector<std::size_t> split(std::string_view data) const;
+
+  [[nodiscard]] const ChunkerParams &params() const { return config; }
+
+private:
+  // AIHasher64 of each single byte value.
+  static constexpr std::array<std::uint64_t, 256> kGear = [] {
+    std::array<std::uint64_t, 256> table{};
+    for (std::size_t b = 0; b < table.size(); ++b) {
+      const char byte[1] = {static_cast<char>(b)};
+      table[b] = AIHasher64::hash(std::string_view(byte, 1), 0x4344435FULL);
+    }
+    return table;
+  }();
+
+  ChunkerParams config;
+  std::uint64_t mask_small;
+  std::uint64_t mask_large;
+};
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+#include "hasher_registry.h"
+#include <hex.h>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+// First N bytes of any registered hasher's digest, the bytes hash256bit
+// hex-encodes. Hashers with a raw digest() skip the hex round trip; AIHasher's
+// digest<N> still squeezes its whole 32-byte block and copies N bytes out.
+// Throws std::invalid_argument if a hex digest does not decode.
+template <std::size_t N, ConcreteHasher H>
+std::array<std::uint8_t, N> digest_bytes(const H &hasher, const std::string &input) {
+  static_assert(N <= 32, "digests are 32 bytes");
+  std::array<std::uint8_t, N> bytes{};
+  if constexpr ((N == 8 || N == 16 || N == 32) &&
+                requires { hasher.template digest<N>(std::string_view(input)); }) {
+    return hasher.template digest<N>(input);
+  } else if constexpr (requires { hasher.digest(std::string_view(input)); }) {
+    const auto full = hasher.digest(input);
+    std::copy_n(full.begin(), N, bytes.begin());
+  } else {
+    const std::string hex = hasher.hash256bit(input);
+    if (hex.size() < 2 * N ||
+        !hex_decode(std::string_view(hex).substr(0, 2 * N), bytes.data())) {
+      throw std::invalid_argument("digest is not hex");
+    }
+  }
+  return bytes;
+}
\ No newline at end of file
@@ -0,0 +1,181 @@
+#pragma once
+#include "AIHasher64.h"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// Open-addressing map from strings to Value. Entries live densely in
+// insertion order (erase moves the last one into the gap); the probe table
+// holds only an entry index and the upper half of the key's hash, so most
+// mismatches are rejected without touching the key. Linear probing with
+// backward-shift deletion, no tombstones.
+template <typename Value, typename Hash = AIHasher64> class FlatStringMap {
+public:
+  using value_type = std::pair<std::string, Value>;
+  using iterator = typename std::vector<value_type>::iterator;
+  using const_iterator = typename std::vector<value_type>::const_iterator;
+
+  FlatStringMap() = default;
+  explicit FlatStringMap(std::size_t expected) { reserve(expected); }
+
+  template <typename... Args>
+  std::pair<Value *, bool> try_emplace(std::string_view key, Args &&...args) {
+    if ((entries.size() + 1) * kMaxLoadDen > slots.size() * kMaxLoadNum) {
+      rehash(std::max<std::size_t>(kMinSlots, slots.size() * 2));
+    }
+    const std::uint64_t hash = Hash{}(key);
+    std::size_t slot = find_slot(key, hash);
+    if (slots[slot].index != kEmpty) {
+      return {&entries[slots[slot].index].second, false};
+    }
+    entries.emplace_back(std::piecewise_construct, std::forward_as_tuple(key),
+                         std::forward_as_tuple(std::forward<Args>(args)...));
+    hashes.push_back(hash);
+    slots[slot] = Slot{static_cast<std::uint32_t>(entries.size() - 1), tag_of(hash)};
+    return {&entries.back().second, true};
+  }
+
+  template <typename V> bool insert_or_assign(std::string_view key, V &&value) {
+    auto [slot, inserted] = try_emplace(key, std::forward<V>(value));
+    if (!inserted) {
+      *slot = std::forward<V>(value);
+    }
+    return inserted;
+  }
+
+  Value &operator[](std::string_view key) { return *try_emplace(key).first; }
+
+  [[nodiscard]] Value *find(std::string_view key) {
+    return const_cast<Value *>(std::as_const(*this).find(key));
+  }
+  [[nodiscard]] const Value *find(std::string_view key) const {
+    if (entries.empty()) {
+      return nullptr;
+    }
+    const std::size_t slot = find_slot(key, Hash{}(key));
+    return slots[slot].index == kEmpty ? nullptr
+                                       : &entries[slots[slot].index].second;
+  }
+  [[nodiscard]] bool contains(std::string_view key) const {
+    return find(key) != nullptr;
+  }
+
+  bool erase(std::string_view key) {
+    if (entries.empty()) {
+      return false;
+    }
+    std::size_t hole = find_slot(key, Hash{}(key));
+    const std::uint32_t removed = slots[hole].index;
+    if (removed == kEmpty) {
+      return false;
+    }
+
+    // Backward shift: pull later members of the probe run into the hole
+    // whenever the hole lies between their home slot and where they sit.
+    const std::size_t mask = slots.size() - 1;
+    for (std::size_t next = (hole + 1) & mask; slots[next].index != kEmpty;
+         next = (next + 1) & mask) {
+      const std::size_t home = hashes[slots[next].index] & mask;
+      if (((next - home) & mask) >= ((next - hole) & mask)) {
+        slots[hole] = slots[next];
+        hole = next;
+      }
+    }
+    slots[hole].index = kEmpty;
+
+    const std::uint32_t last = static_cast<std::uint32_t>(entries.size() - 1);
+    if (removed != last) {
+      slots[slot_of_index(last)].index = removed;
+      entries[removed] = std::move(entries.back());
+      hashes[removed] = hashes.back();
+    }
+    entries.pop_back();
+    hashes.pop_back();
+    return true;
+  }
+
+  void reserve(std::size_t count) {
+    const std::size_t needed = count * kMaxLoadDen / kMaxLoadNum + 1;
+    if (needed > slots.size()) {
+      rehash(std::bit_ceil(std::max(kMinSlots, needed)));
+    }
+    entries.reserve(count);
+    hashes.reserve(count);
+  }
+
+  void clear() {
+    entries.clear();
+    hashes.clear();
+    std::fill(slots.begin(), slots.end(), Slot{});
+  }
+
+  [[nodiscard]] std::size_t size() const { return entries.size(); }
+  [[nodiscard]] bool empty() const { return entries.empty(); }
+  [[nodiscard]] std::size_t bucket_count() const { return slots.size(); }
+
+  iterator begin() { return entries.begin(); }
+  iterator end() { return entries.end(); }
+  const_iterator begin() const { return entries.begin(); }
+  const_iterator end() const { return entries.end(); }
+
+private:
+  static constexpr std::uint32_t kEmpty = std::numeric_limits<std::uint32_t>::max();
+  static constexpr std::size_t kMinSlots = 16;
+  // Maximum load factor 7/8.
+  static constexpr std::size_t kMaxLoadNum = 7;
+  static constexpr std::size_t kMaxLoadDen = 8;
+
+  struct Slot {
+    std::uint32_t index = kEmpty;
+    std::uint32_t tag = 0;
+  };
+
+  static std::uint32_t tag_of(std::uint64_t hash) {
+    return static_cast<std::uint32_t>(hash >> 32U);
+  }
+
+  // The slot holding key, or the empty slot that ends its probe run.
+  std::size_t find_slot(std::string_view key, std::uint64_t hash) const {
+    const std::size_t mask = slots.size() - 1;
+    const std::uint32_t tag = tag_of(hash);
+    for (std::size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+      const Slot &s = slots[slot];
+      if (s.index == kEmpty ||
+          (s.tag == tag && entries[s.index].first == key)) {
+        return slot;
+      }
+    }
+  }
+
+  std::size_t slot_of_index(std::uint32_t index) const {
+    const std::size_t mask = slots.size() - 1;
+    for (std::size_t slot = hashes[index] & mask;; slot = (slot + 1) & mask) {
+      if (slots[slot].index == index) {
+        return slot;
+      }
+    }
+  }
+
+  void rehash(std::size_t slot_count) {
+    slots.assign(slot_count, Slot{});
+    const std::size_t mask = slot_count - 1;
+    for (std::uint32_t i = 0; i < entries.size(); ++i) {
+      std::size_t slot = hashes[i] & mask;
+      while (slots[slot].index != kEmpty) {
+        slot = (slot + 1) & mask;
+      }
+      slots[slot] = Slot{i, tag_of(hashes[i])};
+    }
+  }
+
+  std::vector<value_type> entries;
+  std::vector<std::uint64_t> hashes;
+  std::vector<Slot> slots;
+};
\ No newline at end of file
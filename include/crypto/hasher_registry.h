@@ -0,0 +1,64 @@
+#pragma once
+#include "AIHasher.h"
+#include "AITreeHasher.h"
+#include "Hasher.h"
+#include "IHasher.h"
+#include "sha256_hasher.h"
+#include <array>
+#include <concepts>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// A concrete hasher type. All of them are final, so a call through `const
+// H &` binds statically and can be inlined; generic loops should take the
+// hasher as a template parameter rather than as `const IHasher &`.
+template <typename H>
+concept ConcreteHasher = std::derived_from<H, IHasher> && std::is_final_v<H> &&
+                         std::default_initializable<H>;
+
+template <ConcreteHasher H> struct HasherName;
+template <> struct HasherName<Hasher> {
+  static constexpr std::string_view value = "asmeninis";
+};
+template <> struct HasherName<AIHasher> {
+  static constexpr std::string_view value = "ai";
+};
+template <> struct HasherName<AITreeHasher> {
+  static constexpr std::string_view value = "ai-tree";
+};
+template <> struct HasherName<SHA256_Hasher> {
+  static constexpr std::string_view value = "sha256";
+};
+
+// Runtime selection by name. visit() hands the callback a concrete hasher,
+// so a generic lambda is instantiated once per type and keeps static
+// dispatch inside; make() is the IHasher adapter for code that only needs
+// the virtual interface.
+template <ConcreteHasher... Hs> class BasicHasherRegistry {
+public:
+  static constexpr std::array<std::string_view, sizeof...(Hs)> names() {
+    return {HasherName<Hs>::value...};
+  }
+
+  template <typename Fn> static void visit(std::string_view name, Fn &&fn) {
+    const bool found =
+        ((name == HasherName<Hs>::value ? (fn(Hs{}), true) : false) || ...);
+    if (!found) {
+      throw std::invalid_argument("unknown hasher '" + std::string(name) + "'");
+    }
+  }
+
+  static std::unique_ptr<IHasher> make(std::string_view name) {
+    std::unique_ptr<IHasher> hasher;
+    visit(name, [&hasher](const auto &concrete) {
+      hasher = std::make_unique<std::remove_cvref_t<decltype(concrete)>>(concrete);
+    });
+    return hasher;
+  }
+};
+
+using HasherRegistry =
+    BasicHasherRegistry<Hasher, AIHasher, AITreeHasher, SHA256_Hasher>;
\ No newline at end of file
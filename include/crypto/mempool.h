@@ -0,0 +1,69 @@
+#pragma once
+#include "arena.h"
+#include "transaction.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Pending transactions keyed by txid. Entries are kept in one of 65 fee
+// buckets (bucket = bit width of the fee), each an intrusive FIFO list, with
+// a bitmap of non-empty buckets so the best and worst bucket are found with a
+// single bit scan. Insert, removal by txid and eviction are O(1).
+class Mempool {
+  static constexpr std::uint32_t kNone = 0xFFFFFFFFU;
+  static constexpr std::size_t kBucketCount = 65;
+
+  struct Entry {
+    Transaction transaction;
+    std::uint64_t fee = 0;
+    std::uint32_t bucket = 0;
+    std::uint32_t prev = kNone;
+    std::uint32_t next = kNone;
+  };
+
+  struct Bucket {
+    std::uint32_t head = kNone;
+    std::uint32_t tail = kNone;
+  };
+
+  std::size_t max_size;
+  ChunkedArena<Entry, 12> entries;
+  std::vector<std::uint32_t> free_slots;
+  std::unordered_map<std::string_view, std::uint32_t> by_txid;
+  std::array<Bucket, kBucketCount> buckets{};
+  std::array<std::uint64_t, 2> occupied{};
+  std::size_t evicted = 0;
+
+public:
+  explicit Mempool(std::size_t capacity);
+
+  // Returns false if the txid is already pending, or if the pool is full and
+  // the fee does not beat the lowest bucket.
+  bool add(Transaction transaction, std::uint64_t fee);
+  bool remove(std::string_view txid);
+  // Drops every transaction of a freshly accepted block.
+  void remove_included(std::span<const Transaction> transactions);
+
+  // Highest fee buckets first, oldest first within a bucket. The result is
+  // ready to pass to Block's constructor.
+  [[nodiscard]] std::vector<Transaction>
+  build_template(std::size_t max_transactions) const;
+
+  [[nodiscard]] bool contains(std::string_view txid) const {
+    return by_txid.contains(txid);
+  }
+  [[nodiscard]] std::size_t size() const { return by_txid.size(); }
+  [[nodiscard]] std::size_t capacity() const { return max_size; }
+  [[nodiscard]] std::size_t evictions() const { return evicted; }
+
+private:
+  static std::uint32_t bucket_for(std::uint64_t fee);
+  [[nodiscard]] std::uint32_t lowest_bucket() const;
+  void link(std::uint32_t slot);
+  void unlink(std::uint32_t slot);
+  void erase_slot(std::uint32_t slot);
+};
\ No newline at end of file
@@ -1,10 +1,35 @@
 #pragma once
 
 #include "IHasher.h"
+#include <array>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <string_view>
 
+// SHA-256 through OpenSSL EVP. The digest algorithm is fetched once per
+// process and every thread keeps one context that is re-initialised per
+// message, so short inputs do not pay an allocation and provider lookup.
 class SHA256_Hasher final : public IHasher {
 public:
+  using Digest = std::array<std::uint8_t, 32>;
+
   SHA256_Hasher() {}
+  // HMAC-SHA256 with key. The inner and outer pads are hashed once here;
+  // every message resumes from copies of those two states.
+  explicit SHA256_Hasher(std::string_view key);
   virtual std::string hash256bit(const std::string &input) const override final;
+  virtual std::vector<std::string>
+  hash256bit_batch(std::span<const std::string> inputs) const override final;
+  // Raw 32-byte digest without hex encoding; throws std::runtime_error if
+  // OpenSSL fails.
+  [[nodiscard]] Digest digest(std::string_view input) const;
+  virtual std::unique_ptr<IHasher> keyed(std::string_view key) const override final;
+
+private:
+  struct HmacKey;
+  bool digest_into(std::string_view input, unsigned char *out) const;
+
+  // Null for plain SHA-256. Shared: the padded states are read-only.
+  std::shared_ptr<const HmacKey> hmac;
 };
\ No newline at end of file
@@ -1,3 +1,5 @@
+#pragma once
+#include "AIHasher.h"
 #include <cstdint>
 #include <string>
 struct Transaction {
@@ -5,4 +7,10 @@ struct Transaction {
   std::string sender;
   std::string receiver;
   uint64_t amount;
-};
\ No newline at end of file
+};
+
+const AIHasher &txid_hasher();
+std::string transaction_payload(const Transaction &transaction);
+std::string compute_txid(const Transaction &transaction);
+Transaction make_transaction(std::string sender, std::string receiver,
+                             uint64_t amount);
\ No newline at end of file
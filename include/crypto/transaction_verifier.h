@@ -0,0 +1,43 @@
+#pragma once
+#include "transaction.h"
+#include "user.h"
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string>
+
+struct VerificationTimings {
+  double txid_seconds = 0.0;
+  double conflict_seconds = 0.0;
+  double balance_seconds = 0.0;
+
+  [[nodiscard]] double total() const {
+    return txid_seconds + conflict_seconds + balance_seconds;
+  }
+};
+
+struct VerificationResult {
+  bool valid = true;
+  std::optional<std::size_t> first_invalid_index;
+  std::string reason;
+  VerificationTimings timings;
+};
+
+// Checks a block's transactions in three stages:
+//   1. txids are recomputed in parallel, one hash batch per worker;
+//   2. txids go into a sharded concurrent set to catch the same
+//      transaction appearing twice in one block. Transactions carry no
+//      inputs or nonce, so two equal payments share a txid and only one
+//      of them fits in a block;
+//   3. balances are applied sequentially, rejecting overdrafts and
+//      credits that would overflow a balance.
+// Stage 3 commits the block to the balance index only if every stage passes.
+class TransactionVerifier {
+  unsigned thread_count;
+
+public:
+  explicit TransactionVerifier(unsigned threads = 0) : thread_count(threads) {}
+
+  VerificationResult verify(std::span<const Transaction> transactions,
+                            BalanceIndex &balances) const;
+};
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+#include "arena.h"
+#include "transaction.h"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using UserId = std::uint32_t;
+
+// Interns user names into dense ids. Names live in a chunked arena, so the
+// lookup table can key on views into them.
+class UserTable {
+  ChunkedArena<std::string> names;
+  std::unordered_map<std::string_view, UserId> ids;
+
+public:
+  UserId intern(std::string_view name);
+  [[nodiscard]] std::optional<UserId> find(std::string_view name) const;
+  [[nodiscard]] const std::string &name(UserId id) const;
+  [[nodiscard]] std::size_t size() const { return names.size(); }
+};
+
+enum class BalanceError { overdraft, overflow };
+
+// Balances indexed by UserId, updated one block at a time. Every applied
+// block leaves an undo record so the index can be rolled back on a reorg.
+// A transaction with an empty sender mints coins (block rewards).
+class BalanceIndex {
+  struct BlockUndo {
+    std::vector<std::pair<UserId, std::uint64_t>> previous_balances;
+  };
+
+  UserTable user_table;
+  std::vector<std::uint64_t> balances;
+  std::vector<std::size_t> recorded_in; // 1-based undo_log slot, 0 = none
+  std::vector<BlockUndo> undo_log;
+
+public:
+  // Applies every transaction or none of them; returns false if a sender
+  // would overdraw or a receiver's balance would pass 2^64 - 1, storing the
+  // offending index in failed_index and the cause in error if given.
+  bool apply_block(std::span<const Transaction> transactions,
+                   std::size_t *failed_index = nullptr,
+                   BalanceError *error = nullptr);
+  void rollback_block();
+
+  [[nodiscard]] std::uint64_t balance(UserId id) const;
+  [[nodiscard]] std::uint64_t balance(std::string_view user) const;
+  [[nodiscard]] const UserTable &users() const { return user_table; }
+  [[nodiscard]] std::size_t applied_blocks() const { return undo_log.size(); }
+
+private:
+  UserId touch(std::string_view user, BlockUndo &undo);
+  void restore(const BlockUndo &undo);
+};
\ No newline at end of file
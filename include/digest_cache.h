@@ -0,0 +1,77 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+
+// What a cached digest is valid for: the file's device and inode plus its
+// size and modification time at the moment it was hashed.
+struct FileIdentity {
+  std::uint64_t device = 0;
+  std::uint64_t inode = 0;
+  std::uint64_t size = 0;
+  std::int64_t mtime_ns = 0;
+
+  bool operator==(const FileIdentity &) const = default;
+};
+
+// Throws std::filesystem::filesystem_error if path cannot be stat'ed.
+[[nodiscard]] FileIdentity file_identity(const std::filesystem::path &path);
+
+// Persistent digest cache: an open-addressing hash table in a memory-mapped
+// file, keyed by (device, inode, algorithm id); size and mtime are checked on
+// lookup, so a modified file is a miss and its slot is overwritten.
+//
+// Lookups take no lock. Every entry carries a checksum of its fields, written
+// last, and a reader treats an entry whose checksum does not match as empty,
+// so a torn or half-written entry is never returned. Writers hold an
+// exclusive flock for a whole batch. Growing the table writes a new file and
+// renames it over the old one; other processes notice the new inode on their
+// next store and remap.
+class DigestCache {
+public:
+  using Digest = std::array<std::uint8_t, 32>;
+
+  struct Record {
+    FileIdentity identity;
+    Digest digest;
+  };
+
+  // Opens or creates the cache file (and its parent directory). Throws
+  // std::system_error when the file cannot be created or mapped, or
+  // std::runtime_error when it is not a digest cache.
+  explicit DigestCache(std::filesystem::path path);
+  DigestCache(const DigestCache &) = delete;
+  DigestCache &operator=(const DigestCache &) = delete;
+  ~DigestCache();
+
+  [[nodiscard]] std::optional<Digest> find(const FileIdentity &identity,
+                                           std::uint64_t algorithm) const;
+  // Returns how many records were stored. Files modified within the last
+  // kRacyWindowNs are skipped: another write in the same mtime tick would
+  // leave the cached digest stale behind an unchanged identity.
+  std::size_t store(std::span<const Record> records, std::uint64_t algorithm);
+
+  [[nodiscard]] std::size_t size() const;
+  [[nodiscard]] std::size_t capacity() const;
+  [[nodiscard]] std::size_t hits() const { return hit_count.load(); }
+  [[nodiscard]] std::size_t misses() const { return miss_count.load(); }
+
+  static constexpr std::int64_t kRacyWindowNs = 2'000'000'000;
+
+private:
+  void map_file();
+  void unmap();
+  void reopen_if_replaced();
+  void grow(std::size_t min_entries);
+
+  std::filesystem::path path;
+  int fd = -1;
+  void *mapping = nullptr;
+  std::size_t mapped_size = 0;
+  mutable std::atomic<std::size_t> hit_count{0};
+  mutable std::atomic<std::size_t> miss_count{0};
+};
\ No newline at end of file
@@ -0,0 +1,85 @@
+#pragma once
+#include <thread_pool.h>
+#include <array>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <span>
+#include <vector>
+
+// Duplicate detection over more digests than fit in memory. Records are
+// collected into runs of a fixed size; each run is sorted in memory and
+// written to its own file while the next one fills. merge_runs() then maps
+// every run file and walks them together in digest order, so a duplicate
+// shows up as equal neighbours. Memory is two runs while writing and one
+// record per run while merging, and the disk only sees sequential I/O.
+struct DigestRecord {
+  std::array<std::uint8_t, 32> digest;
+  // The caller's id for the hashed input: an index, a file offset.
+  std::uint64_t source;
+
+  auto operator<=>(const DigestRecord &) const = default;
+};
+
+static_assert(sizeof(DigestRecord) == 40);
+
+// Writes records sorted by digest, then source, to out (same size). The
+// first digest byte is scattered in parallel, then the 256 buckets are
+// sorted in parallel.
+void radix_sort_records(std::span<const DigestRecord> records, std::span<DigestRecord> out,
+                        ThreadPool &pool = ThreadPool::global());
+
+class DigestRunWriter {
+public:
+  // Writes run_0.bin, run_1.bin, ... into dir, creating it. Holds two
+  // buffers of run_records records. Throws std::system_error on I/O errors.
+  DigestRunWriter(std::filesystem::path dir, std::size_t run_records);
+  DigestRunWriter(const DigestRunWriter &) = delete;
+  DigestRunWriter &operator=(const DigestRunWriter &) = delete;
+  // Waits for the last write; buffered records that were not flushed are
+  // dropped.
+  ~DigestRunWriter();
+
+  // The next count records of the current run, at most free_records(), for
+  // the caller to fill (in parallel if it likes).
+  std::span<DigestRecord> append(std::size_t count);
+  [[nodiscard]] std::size_t free_records() const { return buffer.size() - filled; }
+
+  // Sorts the buffered records and starts writing them as a run; returns
+  // once the buffer may be refilled. Does nothing when it is empty.
+  void flush();
+  // Flushes and waits for every run to be on disk.
+  [[nodiscard]] const std::vector<std::filesystem::path> &finish();
+
+private:
+  std::filesystem::path dir;
+  std::vector<DigestRecord> buffer;
+  std::vector<DigestRecord> sorted;
+  std::size_t filled = 0;
+  std::future<void> writing;
+  std::vector<std::filesystem::path> paths;
+};
+
+struct DuplicateDigest {
+  std::array<std::uint8_t, 32> digest;
+  // Sources of every record with this digest, ascending.
+  std::vector<std::uint64_t> sources;
+};
+
+struct MergeStats {
+  std::uint64_t records = 0;
+  std::uint64_t bytes = 0;
+  // Digests seen more than once, and the records carrying them.
+  std::uint64_t duplicate_digests = 0;
+  std::uint64_t duplicate_records = 0;
+};
+
+// K-way merge of sorted run files; on_duplicate is called in digest order
+// for every digest found in more than one record. Throws std::system_error
+// when a run cannot be mapped and std::runtime_error when one is not a
+// whole number of records or not sorted.
+MergeStats merge_runs(std::span<const std::filesystem::path> runs,
+                      const std::function<void(const DuplicateDigest &)> &on_duplicate);
\ No newline at end of file
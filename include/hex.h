@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Lowercase hex encoding and validated decoding shared by every hasher and
+// the diff utilities. The best kernel for the running CPU (AVX2, SSSE3 or a
+// table-driven scalar loop) is picked once on first use; decoding accepts
+// either case.
+
+// One encode/decode implementation. decode() reads 2 * size characters into
+// size bytes and returns the offset of the first character that is not a
+// hex digit, or kHexValid; out is unspecified when it fails.
+struct HexCodec {
+  const char *name;
+  void (*encode)(const std::uint8_t *in, std::size_t size, char *out);
+  std::size_t (*decode)(const char *in, std::size_t size, std::uint8_t *out);
+};
+
+inline constexpr std::size_t kHexValid = static_cast<std::size_t>(-1);
+
+// Kernels usable on this CPU, scalar first and the one in use last.
+[[nodiscard]] std::span<const HexCodec> hex_codecs();
+
+void hex_encode(std::span<const std::uint8_t> bytes, char *out);
+[[nodiscard]] std::string hex_encode(std::span<const std::uint8_t> bytes);
+
+// Throws std::invalid_argument naming the offending character and offset on
+// odd-length or non-hex input.
+[[nodiscard]] std::vector<std::uint8_t> hex_decode(std::string_view hex);
+// Non-throwing form: out must hold hex.size() / 2 bytes. On failure returns
+// false and, if error_offset is given, stores the offset of the first bad
+// character (hex.size() for an odd length).
+bool hex_decode(std::string_view hex, std::uint8_t *out,
+                std::size_t *error_offset = nullptr);
+
+// Value of one hex digit, or -1.
+[[nodiscard]] int hex_value(char c);
\ No newline at end of file
@@ -0,0 +1,102 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// HDR-style histogram of non-negative integers (latencies in ns or ticks).
+// Values below 256 get a bucket each; every power-of-two range above is cut
+// into 128 equal buckets, so any value is kept to within 1/128 of itself
+// over the whole 64-bit range in a fixed 58 KiB of counters. Histograms
+// filled on different threads are combined with merge().
+class LatencyHistogram {
+public:
+  static constexpr unsigned kSubBucketBits = 8;
+
+  LatencyHistogram() : counts(kBucketCount, 0) {}
+
+  void record(std::uint64_t value, std::uint64_t count = 1) {
+    counts[index_of(value)] += count;
+    total += count;
+    sum += static_cast<double>(value) * static_cast<double>(count);
+    min_value = std::min(min_value, value);
+    max_value = std::max(max_value, value);
+  }
+
+  void merge(const LatencyHistogram &other) {
+    for (std::size_t i = 0; i < kBucketCount; ++i) {
+      counts[i] += other.counts[i];
+    }
+    total += other.total;
+    sum += other.sum;
+    min_value = std::min(min_value, other.min_value);
+    max_value = std::max(max_value, other.max_value);
+  }
+
+  void reset() {
+    std::fill(counts.begin(), counts.end(), 0);
+    total = 0;
+    sum = 0.0;
+    min_value = std::numeric_limits<std::uint64_t>::max();
+    max_value = 0;
+  }
+
+  // Value at quantile q in [0, 1]: the top of the bucket holding the
+  // ceil(q * count())-th smallest sample, capped at max(). 0 when empty.
+  [[nodiscard]] std::uint64_t percentile(double q) const {
+    if (total == 0) {
+      return 0;
+    }
+    const double clamped = std::clamp(q, 0.0, 1.0);
+    const auto rank = std::max<std::uint64_t>(
+        1, static_cast<std::uint64_t>(std::ceil(clamped * static_cast<double>(total))));
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < kBucketCount; ++i) {
+      seen += counts[i];
+      if (seen >= rank) {
+        return std::clamp(highest_in(i), min_value, max_value);
+      }
+    }
+    return max_value;
+  }
+
+  [[nodiscard]] std::uint64_t count() const { return total; }
+  [[nodiscard]] std::uint64_t min() const { return total == 0 ? 0 : min_value; }
+  [[nodiscard]] std::uint64_t max() const { return max_value; }
+  [[nodiscard]] double mean() const {
+    return total == 0 ? 0.0 : sum / static_cast<double>(total);
+  }
+
+private:
+  static constexpr std::size_t kLinear = std::size_t{1} << kSubBucketBits;
+  static constexpr std::size_t kHalf = kLinear / 2;
+  static constexpr std::size_t kBucketCount = (64 - kSubBucketBits + 1) * kHalf + kHalf;
+
+  // Above the linear range the value is shifted right by e until it has
+  // kSubBucketBits bits; e picks the range, the shifted value the bucket.
+  static std::size_t index_of(std::uint64_t value) {
+    if (value < kLinear) {
+      return static_cast<std::size_t>(value);
+    }
+    const unsigned e = static_cast<unsigned>(std::bit_width(value)) - kSubBucketBits;
+    return e * kHalf + static_cast<std::size_t>(value >> e);
+  }
+
+  static std::uint64_t highest_in(std::size_t index) {
+    if (index < kLinear) {
+      return index;
+    }
+    const unsigned e = static_cast<unsigned>(index / kHalf - 1);
+    const std::uint64_t lowest = static_cast<std::uint64_t>(index - e * kHalf) << e;
+    return lowest + ((std::uint64_t{1} << e) - 1);
+  }
+
+  std::vector<std::uint64_t> counts;
+  std::uint64_t total = 0;
+  double sum = 0.0;
+  std::uint64_t min_value = std::numeric_limits<std::uint64_t>::max();
+  std::uint64_t max_value = 0;
+};
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+enum class PerfEvent : std::uint8_t {
+  cycles,
+  instructions,
+  branch_misses,
+  l1d_misses,
+  llc_misses,
+};
+
+inline constexpr std::size_t kPerfEventCount = 5;
+
+// Counts over one measured region; an event that could not be opened is
+// nullopt. Counts are scaled up when the kernel multiplexed the counter.
+struct PerfSample {
+  std::array<std::optional<std::uint64_t>, kPerfEventCount> values{};
+
+  [[nodiscard]] std::optional<std::uint64_t> operator[](PerfEvent event) const {
+    return values[static_cast<std::size_t>(event)];
+  }
+  // Instructions per cycle, if both were counted.
+  [[nodiscard]] std::optional<double> ipc() const;
+  // event / bytes, if it was counted and bytes is not 0.
+  [[nodiscard]] std::optional<double> per_byte(PerfEvent event,
+                                               std::size_t bytes) const;
+  PerfSample &operator+=(const PerfSample &other);
+};
+
+// Hardware counters of the calling thread (user space only) through Linux
+// perf_event_open. Work handed to pool workers is not counted; callers that may
+// run parallel code check ThreadPool::worker_tasks() around the region. Every
+// event is opened on its own, so a PMU that lacks one of them, e.g. LLC misses
+// in a VM, still yields the rest. Containers and kernels that refuse perf
+// events get a PerfCounters that counts nothing: available() is false and
+// reason() says why, so callers just leave the columns out.
+class PerfCounters {
+public:
+  PerfCounters();
+  PerfCounters(const PerfCounters &) = delete;
+  PerfCounters &operator=(const PerfCounters &) = delete;
+  ~PerfCounters();
+
+  void start();
+  PerfSample stop();
+
+  [[nodiscard]] bool available() const;
+  [[nodiscard]] bool available(PerfEvent event) const;
+  // Why the first unavailable event failed to open; empty if all opened.
+  [[nodiscard]] const std::string &reason() const { return failure; }
+
+  [[nodiscard]] static std::string_view name(PerfEvent event);
+
+private:
+  std::array<int, kPerfEventCount> fds;
+  std::string failure;
+};
\ No newline at end of file
@@ -0,0 +1,252 @@
+#pragma once
+#include <crypto/digest_bytes.h>
+#include <crypto/hasher_registry.h>
+#include <thread_pool.h>
+#include <Timer.h>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Collisions of a hasher truncated to k bits, found with parallel Pollard
+// rho (van Oorschot-Wiener). The walk x -> f(x) hashes the k-bit value x
+// written as hex and keeps the low k bits of the digest. Every worker
+// walks from random starts until it reaches a distinguished point (low d
+// bits zero) and records it with its start in a shared table; two walks
+// that end in the same point have merged, and re-walking both from their
+// starts finds the two inputs with the same truncated digest. Memory is a
+// few distinguished points instead of every value seen.
+namespace rho {
+
+struct RhoOptions {
+  // Digest bits compared, 1 to 64.
+  unsigned bits = 32;
+  // Distinguished point bits; 0 picks one from bits.
+  unsigned distinguished_bits = 0;
+  std::uint64_t seed = 1;
+  // Workers; 0 uses the whole pool.
+  unsigned threads = 0;
+};
+
+struct RhoCollision {
+  std::string hasher;
+  unsigned bits = 0;
+  unsigned distinguished_bits = 0;
+  // Two different messages whose truncated digests are both value.
+  std::string first;
+  std::string second;
+  std::uint64_t value = 0;
+  // Hash calls by all workers, re-walks included.
+  std::uint64_t evaluations = 0;
+  std::uint64_t distinguished_points = 0;
+  // Merged walks that did not lead to a collision: one start lay on the
+  // other walk, or the pair did not hash the same when checked again.
+  std::uint64_t false_alarms = 0;
+  double seconds = 0.0;
+};
+
+// sqrt(pi / 2 * 2^bits): mean hash calls until the first collision of a
+// random function on bits bits.
+[[nodiscard]] double expected_evaluations(unsigned bits);
+// Distinguished bits used when RhoOptions leaves it 0: walks of about
+// 2^(bits/2 - 14), so a search records around 2^14 points.
+[[nodiscard]] unsigned default_distinguished_bits(unsigned bits);
+
+// The message hashed for x: ceil(bits / 4) lowercase hex digits.
+void write_message(std::uint64_t x, unsigned bits, std::string &out);
+
+// Distinguished point -> walk start and length, shared by all workers.
+// Open addressing over a fixed array: a slot is claimed with one CAS on
+// its state and published with a release store, so inserts never take a
+// lock; a probe that meets a slot being written waits for those stores.
+class DistinguishedPointTable {
+public:
+  struct Trail {
+    std::uint64_t start = 0;
+    std::uint64_t length = 0;
+  };
+
+  // slots is rounded up to a power of two.
+  explicit DistinguishedPointTable(std::size_t slots);
+
+  // Records point, or returns the trail already recorded for it. Throws
+  // std::length_error when the table is full.
+  std::optional<Trail> insert(std::uint64_t point, const Trail &trail);
+  [[nodiscard]] std::size_t size() const { return count.load(std::memory_order_relaxed); }
+  [[nodiscard]] std::size_t capacity() const { return slot_count; }
+
+private:
+  enum : std::uint32_t { kEmpty, kWriting, kReady };
+
+  struct Slot {
+    std::atomic<std::uint32_t> state{kEmpty};
+    std::uint64_t point = 0;
+    Trail trail;
+  };
+
+  std::size_t slot_count;
+  std::unique_ptr<Slot[]> slots;
+  std::atomic<std::size_t> count{0};
+};
+
+void write_table(std::ostream &os, std::span<const RhoCollision> results);
+
+namespace detail {
+
+inline std::uint64_t mask(unsigned bits) {
+  return bits >= 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << bits) - 1;
+}
+
+inline std::uint64_t splitmix64(std::uint64_t &state) {
+  std::uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27U)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31U);
+}
+
+template <ConcreteHasher H> class Walk {
+public:
+  Walk(const H &hasher, unsigned bits) : hasher(hasher), bits(bits), low(mask(bits)) {}
+
+  std::uint64_t operator()(std::uint64_t x) {
+    write_message(x, bits, message);
+    const auto digest = digest_bytes<8>(hasher, message);
+    std::uint64_t value = 0;
+    for (std::size_t b = 0; b < digest.size(); ++b) {
+      value |= static_cast<std::uint64_t>(digest[b]) << (b * 8U);
+    }
+    ++evaluations;
+    return value & low;
+  }
+
+  std::uint64_t evaluations = 0;
+
+private:
+  const H &hasher;
+  unsigned bits;
+  std::uint64_t low;
+  std::string message;
+};
+
+} // namespace detail
+
+template <ConcreteHasher H>
+RhoCollision find_collision(const H &hasher, const RhoOptions &options,
+                            ThreadPool &pool = ThreadPool::global()) {
+  if (options.bits == 0 || options.bits > 64) {
+    throw std::invalid_argument("collision bits must be 1 to 64");
+  }
+  const unsigned bits = options.bits;
+  const unsigned dp_bits = options.distinguished_bits != 0
+                               ? std::min(options.distinguished_bits, bits - 1)
+                               : default_distinguished_bits(bits);
+  const std::uint64_t dp_mask = detail::mask(dp_bits);
+  // Walks stuck in a cycle without a distinguished point are dropped.
+  const std::uint64_t max_walk = std::uint64_t{20} << dp_bits;
+  // Room for 16x the expected number of points before giving up.
+  DistinguishedPointTable table(std::max<std::size_t>(
+      1024, static_cast<std::size_t>(16.0 * expected_evaluations(bits) /
+                                     static_cast<double>(std::uint64_t{1} << dp_bits))));
+  const unsigned workers =
+      options.threads == 0 ? pool.size() : std::min(options.threads, pool.size());
+
+  RhoCollision result;
+  result.hasher = std::string(HasherName<H>::value);
+  result.bits = bits;
+  result.distinguished_bits = dp_bits;
+  std::atomic<bool> found{false};
+  std::atomic<std::uint64_t> evaluations{0};
+  std::atomic<std::uint64_t> false_alarms{0};
+  std::mutex error_mutex;
+  std::exception_ptr error;
+
+  Timer timer;
+  pool.parallel_for(
+      std::max(1U, workers), 1,
+      [&](std::size_t begin, std::size_t end) {
+        for (std::size_t worker = begin; worker < end; ++worker) {
+          detail::Walk<H> f(hasher, bits);
+          std::uint64_t rng = options.seed * 0x100000001B3ULL + worker;
+          try {
+            while (!found.load(std::memory_order_relaxed)) {
+              const std::uint64_t start = detail::splitmix64(rng) & detail::mask(bits);
+              std::uint64_t x = f(start);
+              std::uint64_t length = 1;
+              while ((x & dp_mask) != 0 && length < max_walk &&
+                     !found.load(std::memory_order_relaxed)) {
+                x = f(x);
+                ++length;
+              }
+              if ((x & dp_mask) != 0) {
+                continue;
+              }
+              const auto other = table.insert(x, {start, length});
+              if (!other || other->start == start) {
+                continue;
+              }
+              // Line the walks up at the same distance from the point, then
+              // step both until they meet.
+              std::uint64_t a = other->start;
+              std::uint64_t b = start;
+              for (std::uint64_t la = other->length; la > length; --la) {
+                a = f(a);
+              }
+              for (std::uint64_t lb = length; lb > other->length; --lb) {
+                b = f(b);
+              }
+              if (a == b) {
+                false_alarms.fetch_add(1, std::memory_order_relaxed);
+                continue;
+              }
+              std::uint64_t fa = f(a);
+              std::uint64_t fb = f(b);
+              while (fa != fb) {
+                a = fa;
+                b = fb;
+                fa = f(a);
+                fb = f(b);
+              }
+              // Hash both again before reporting them, so a walk that was not
+              // a function of its input (a hasher with shared state raced by
+              // another worker) cannot produce a pair that does not collide.
+              if (f(a) != fa || f(b) != fb) {
+                false_alarms.fetch_add(1, std::memory_order_relaxed);
+                continue;
+              }
+              if (!found.exchange(true)) {
+                write_message(a, bits, result.first);
+                write_message(b, bits, result.second);
+                result.value = fa;
+              }
+            }
+          } catch (...) {
+            std::lock_guard lock(error_mutex);
+            if (!error) {
+              error = std::current_exception();
+            }
+            found.store(true);
+          }
+          evaluations.fetch_add(f.evaluations, std::memory_order_relaxed);
+        }
+      },
+      std::max(1U, workers));
+  if (error) {
+    std::rethrow_exception(error);
+  }
+  result.seconds = timer.elapsed();
+  result.evaluations = evaluations.load();
+  result.distinguished_points = table.size();
+  result.false_alarms = false_alarms.load();
+  return result;
+}
+
+} // namespace rho
\ No newline at end of file
@@ -0,0 +1,203 @@
+#pragma once
+#include <crypto/digest_bytes.h>
+#include <crypto/hasher_registry.h>
+#include <thread_pool.h>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Strict avalanche criterion and output bit bias of a hasher. Every sample
+// is a random message; each of its input bits is flipped in turn and the
+// 256-bit XOR of the two digests is added to an input-bit x output-bit
+// flip count matrix. The unflipped digests count how often each output bit
+// is set. An ideal hash flips every output bit with probability 1/2 and
+// sets it with probability 1/2.
+namespace sac {
+
+inline constexpr std::size_t kDigestBits = 256;
+
+using DigestWords = std::array<std::uint64_t, kDigestBits / 64>;
+
+struct SacOptions {
+  // Random messages; each costs input_bytes * 8 + 1 digests.
+  std::uint64_t samples = 1U << 16U;
+  std::size_t input_bytes = 8;
+  std::uint64_t seed = 1;
+};
+
+struct SacResult {
+  std::string hasher;
+  std::size_t input_bits = 0;
+  std::uint64_t samples = 0;
+  // flips[in * kDigestBits + out]: output bit out changed when input bit in
+  // was flipped.
+  std::vector<std::uint64_t> flips;
+  // Set bits of the unflipped digests.
+  std::array<std::uint64_t, kDigestBits> ones{};
+  // Hamming distances of all flipped pairs, 0 to 256.
+  std::array<std::uint64_t, kDigestBits + 1> distances{};
+
+  [[nodiscard]] double flip_probability(std::size_t in, std::size_t out) const;
+  // Share of digests with the bit set, minus 1/2.
+  [[nodiscard]] double bias(std::size_t out) const;
+  // One degree of freedom against a fair coin.
+  [[nodiscard]] double bias_chi_squared(std::size_t out) const;
+  void merge(const SacResult &other);
+};
+
+struct SacSummary {
+  double mean_flip_probability = 0.0;
+  // Largest |p - 1/2| over the matrix and where it is.
+  double max_flip_deviation = 0.0;
+  std::size_t worst_input_bit = 0;
+  std::size_t worst_output_bit = 0;
+  // Sum of the per-cell chi-squared values; sac_z is its Wilson-Hilferty
+  // normal score, so |z| above ~3 means the matrix is not a fair coin.
+  double sac_chi_squared = 0.0;
+  std::size_t sac_degrees = 0;
+  double sac_z = 0.0;
+  double max_bias = 0.0;
+  std::size_t most_biased_bit = 0;
+  double bias_chi_squared = 0.0;
+  double bias_z = 0.0;
+  double mean_distance = 0.0;
+  std::size_t min_distance = 0;
+  std::size_t max_distance = 0;
+};
+
+[[nodiscard]] SacSummary summarize(const SacResult &result);
+// Wilson-Hilferty approximation of a chi-squared value as a standard normal.
+[[nodiscard]] double chi_squared_z(double chi_squared, std::size_t degrees);
+
+void write_summary_table(std::ostream &os, std::span<const SacResult> results);
+// Matrix of flip probabilities, one row per input bit, for plotting.
+void write_matrix(const SacResult &result, const std::filesystem::path &path);
+// "Bit Ones Bias Chi2" per output bit.
+void write_bias(const SacResult &result, const std::filesystem::path &path);
+
+// Per-column counts of 256-bit words. The running counts are kept
+// bit-sliced: plane p holds bit p of every column's count, so adding a
+// word is a carry ripple of whole-word AND/XORs, which vectorize, instead
+// of 256 shifts. The planes are added into the plain counters before the
+// 8-bit sliced counts can overflow and by flush(), which must run before
+// the counters are read.
+class DigestBitCounter {
+public:
+  explicit DigestBitCounter(std::uint64_t *counts) : counts(counts) {}
+
+  void add(const DigestWords &word) {
+    DigestWords carry = word;
+    for (DigestWords &plane : planes) {
+      for (std::size_t w = 0; w < carry.size(); ++w) {
+        const std::uint64_t next = plane[w] & carry[w];
+        plane[w] ^= carry[w];
+        carry[w] = next;
+      }
+    }
+    if (++pending == kMaxPending) {
+      flush();
+    }
+  }
+
+  void flush();
+
+private:
+  static constexpr std::size_t kPlanes = 8;
+  static constexpr unsigned kMaxPending = (1U << kPlanes) - 1;
+
+  std::array<DigestWords, kPlanes> planes{};
+  unsigned pending = 0;
+  std::uint64_t *counts;
+};
+
+namespace detail {
+
+inline DigestWords load_words(const std::uint8_t *bytes) {
+  DigestWords words{};
+  for (std::size_t b = 0; b < kDigestBits / 8; ++b) {
+    words[b / 8] |= static_cast<std::uint64_t>(bytes[b]) << ((b % 8) * 8U);
+  }
+  return words;
+}
+
+template <ConcreteHasher H>
+DigestWords digest_words(const H &hasher, const std::string &input) {
+  return load_words(digest_bytes<kDigestBits / 8>(hasher, input).data());
+}
+
+// splitmix64 of the seed and sample index, so sample i is the same message
+// however the samples are split over threads.
+inline std::uint64_t sample_word(std::uint64_t seed, std::uint64_t index) {
+  std::uint64_t z = seed + index * 0x9E3779B97F4A7C15ULL;
+  z = (z ^ (z >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27U)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31U);
+}
+
+} // namespace detail
+
+template <ConcreteHasher H>
+SacResult analyze(const H &hasher, const SacOptions &options,
+                  ThreadPool &pool = ThreadPool::global()) {
+  const std::size_t input_bits = options.input_bytes * 8;
+  SacResult total;
+  total.hasher = std::string(HasherName<H>::value);
+  total.input_bits = input_bits;
+  total.samples = options.samples;
+  total.flips.assign(input_bits * kDigestBits, 0);
+
+  std::mutex mutex;
+  pool.parallel_for(options.samples, 16, [&](std::size_t begin, std::size_t end) {
+    SacResult local;
+    local.flips.assign(input_bits * kDigestBits, 0);
+    std::vector<DigestBitCounter> rows;
+    rows.reserve(input_bits);
+    for (std::size_t in = 0; in < input_bits; ++in) {
+      rows.emplace_back(local.flips.data() + in * kDigestBits);
+    }
+    DigestBitCounter ones(local.ones.data());
+    const std::size_t words_per_message = (options.input_bytes + 7) / 8;
+    std::string message(options.input_bytes, '\0');
+    for (std::size_t s = begin; s < end; ++s) {
+      for (std::size_t b = 0; b < message.size(); b += 8) {
+        const std::uint64_t word =
+            detail::sample_word(options.seed, s * words_per_message + b / 8);
+        for (std::size_t k = 0; k < 8 && b + k < message.size(); ++k) {
+          message[b + k] = static_cast<char>(word >> (k * 8U));
+        }
+      }
+      const DigestWords base = detail::digest_words(hasher, message);
+      ones.add(base);
+      for (std::size_t in = 0; in < input_bits; ++in) {
+        const auto mask = static_cast<char>(1U << (in % 8));
+        message[in / 8] ^= mask;
+        DigestWords diff = detail::digest_words(hasher, message);
+        message[in / 8] ^= mask;
+        int distance = 0;
+        for (std::size_t w = 0; w < diff.size(); ++w) {
+          diff[w] ^= base[w];
+          distance += std::popcount(diff[w]);
+        }
+        ++local.distances[static_cast<std::size_t>(distance)];
+        rows[in].add(diff);
+      }
+    }
+    for (DigestBitCounter &row : rows) {
+      row.flush();
+    }
+    ones.flush();
+    std::lock_guard lock(mutex);
+    total.merge(local);
+  });
+  return total;
+}
+
+} // namespace sac
\ No newline at end of file
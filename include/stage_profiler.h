@@ -0,0 +1,148 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#ifndef HASHF_INSTRUMENT
+#define HASHF_INSTRUMENT 0
+#endif
+
+#if HASHF_INSTRUMENT
+#include <array>
+#include <atomic>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+#endif
+
+// Per-stage cycle and call counters for the hasher pipelines, compiled in
+// with -DHASHF_INSTRUMENT=ON. When it is off every scope is an empty struct
+// and the hooks are empty constexpr functions, so the hashers compile to the
+// same code as without them.
+//
+// Each thread counts into its own thread-local block; report() sums the
+// blocks of live threads and of threads that have exited. Cycles are self
+// time: a stage nested in another is subtracted from the outer one.
+namespace stage_profiler {
+
+enum class Stage : std::uint8_t {
+  ai_absorb,
+  ai_mix_primary,
+  ai_mix_secondary,
+  ai_mix_final,
+  ai_collapse,
+  ai_to_hex,
+  asmeninis_absorb,
+  asmeninis_diffuse,
+  asmeninis_collapse,
+  asmeninis_to_hex,
+};
+
+inline constexpr std::size_t kStageCount = 10;
+inline constexpr bool kEnabled = HASHF_INSTRUMENT != 0;
+
+struct StageTotals {
+  std::string_view hasher;
+  std::string_view stage;
+  std::uint64_t calls = 0;
+  std::uint64_t cycles = 0;
+};
+
+// Totals of every stage, in enum order; empty when compiled out.
+[[nodiscard]] std::vector<StageTotals> report();
+// Zeroes all counters. Counts from hashing running concurrently may be lost.
+void reset();
+// Name of the counter behind "cycles": "tsc" or "steady_clock_ns".
+[[nodiscard]] std::string_view clock_name();
+
+// Markdown table with cycles per call and each stage's share of its hasher.
+void write_table(std::ostream &os, std::span<const StageTotals> totals);
+void write_json(std::ostream &os, std::span<const StageTotals> totals);
+
+#if HASHF_INSTRUMENT
+
+struct ThreadCounters {
+  ThreadCounters();
+  ~ThreadCounters();
+  ThreadCounters(const ThreadCounters &) = delete;
+  ThreadCounters &operator=(const ThreadCounters &) = delete;
+
+  // Written only by the owning thread; atomic so report() may read them.
+  std::array<std::atomic<std::uint64_t>, kStageCount> calls{};
+  std::array<std::atomic<std::uint64_t>, kStageCount> cycles{};
+  // Cycles spent in stages nested inside the innermost open one.
+  std::uint64_t nested = 0;
+};
+
+inline thread_local ThreadCounters thread_counters;
+
+inline std::uint64_t read_cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return static_cast<std::uint64_t>(
+      std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+struct StageScope {
+  std::uint64_t start = 0;
+  std::uint64_t outer_nested = 0;
+};
+
+// begin/end pairs are for the constexpr stages; both do nothing in constant
+// evaluation.
+constexpr StageScope begin() {
+  if (std::is_constant_evaluated()) {
+    return {};
+  }
+  ThreadCounters &counters = thread_counters;
+  const std::uint64_t outer_nested = counters.nested;
+  counters.nested = 0;
+  return {read_cycles(), outer_nested};
+}
+
+constexpr void end(Stage stage, const StageScope &scope) {
+  if (std::is_constant_evaluated()) {
+    return;
+  }
+  const std::uint64_t elapsed = read_cycles() - scope.start;
+  ThreadCounters &counters = thread_counters;
+  const auto i = static_cast<std::size_t>(stage);
+  const std::uint64_t self = elapsed > counters.nested ? elapsed - counters.nested : 0;
+  counters.calls[i].store(counters.calls[i].load(std::memory_order_relaxed) + 1,
+                          std::memory_order_relaxed);
+  counters.cycles[i].store(counters.cycles[i].load(std::memory_order_relaxed) + self,
+                           std::memory_order_relaxed);
+  counters.nested = scope.outer_nested + elapsed;
+}
+
+#else
+
+struct StageScope {};
+
+constexpr StageScope begin() { return {}; }
+constexpr void end(Stage, const StageScope &) {}
+
+#endif
+
+// Scope guard for stages in ordinary functions.
+class StageTimer {
+public:
+  explicit StageTimer(Stage stage) : stage(stage), scope(begin()) {}
+  StageTimer(const StageTimer &) = delete;
+  StageTimer &operator=(const StageTimer &) = delete;
+  ~StageTimer() { end(stage, scope); }
+
+private:
+  [[maybe_unused]] Stage stage;
+  StageScope scope;
+};
+
+} // namespace stage_profiler
\ No newline at end of file
@@ -0,0 +1,160 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Process-wide work-stealing pool. Every worker owns a deque: it pushes and
+// pops at the back, idle workers steal from the front of the others. Tasks
+// submitted from outside the pool go to a shared injection queue.
+//
+// Waiting is always "helping": a thread blocked in TaskGroup::wait keeps
+// running queued tasks, so parallel code may call parallel code (a batch of
+// large messages, each hashed with a parallel absorb) without deadlocking or
+// starting more threads than the pool has.
+class ThreadPool {
+public:
+  using Task = std::function<void()>;
+
+  explicit ThreadPool(unsigned thread_count = 0, bool pin_threads = false);
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+  ~ThreadPool();
+
+  // Started on first use. The size comes from configure(), else the
+  // HASHF_THREADS environment variable, else hardware_concurrency();
+  // HASHF_PIN_THREADS=1 pins worker i to CPU i.
+  static ThreadPool &global();
+  // Must be called before the first global() call; throws otherwise.
+  static void configure(unsigned thread_count, bool pin_threads = false);
+
+  [[nodiscard]] unsigned size() const {
+    return static_cast<unsigned>(workers.size());
+  }
+
+  void push(Task task);
+  // Runs one queued task on the calling thread, if there is one.
+  bool try_run_one();
+  // Tasks the pool's own workers have started, not counting those run by
+  // threads helping in TaskGroup::wait. Unchanged across a call means the
+  // call did all of its work on the calling thread.
+  [[nodiscard]] std::uint64_t worker_tasks() const {
+    return worker_task_count.load(std::memory_order_relaxed);
+  }
+
+  template <typename Fn>
+  auto submit(Fn &&fn) -> std::future<std::invoke_result_t<std::decay_t<Fn>>> {
+    using Result = std::invoke_result_t<std::decay_t<Fn>>;
+    auto task =
+        std::make_shared<std::packaged_task<Result()>>(std::forward<Fn>(fn));
+    auto future = task->get_future();
+    push([task]() { (*task)(); });
+    return future;
+  }
+
+  // Splits [0, count) into at most max_tasks ranges of at least
+  // min_per_task elements and calls fn(begin, end) for each. max_tasks == 0
+  // means "a few per worker". Returns once every range is done.
+  template <typename Fn>
+  void parallel_for(std::size_t count, std::size_t min_per_task, const Fn &fn,
+                    std::size_t max_tasks = 0);
+
+private:
+  struct Worker {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+    std::thread thread;
+  };
+
+  void run_worker(std::size_t index, bool pin);
+  bool pop_local(std::size_t index, Task &task);
+  bool steal(std::size_t thief, Task &task);
+  bool pop_injected(Task &task);
+
+  std::vector<std::unique_ptr<Worker>> workers;
+  std::mutex injected_mutex;
+  std::deque<Task> injected;
+  std::mutex sleep_mutex;
+  std::condition_variable wake;
+  std::atomic<std::size_t> queued{0};
+  std::atomic<std::uint64_t> worker_task_count{0};
+  std::atomic<bool> stopping{false};
+};
+
+// Tracks a set of tasks on a pool; wait() helps run them and rethrows the
+// first exception any of them threw.
+class TaskGroup {
+public:
+  explicit TaskGroup(ThreadPool &pool = ThreadPool::global()) : pool(pool) {}
+  TaskGroup(const TaskGroup &) = delete;
+  TaskGroup &operator=(const TaskGroup &) = delete;
+  ~TaskGroup();
+
+  template <typename Fn> void run(Fn &&fn) {
+    pending.fetch_add(1, std::memory_order_relaxed);
+    pool.push([this, fn = std::forward<Fn>(fn)]() mutable {
+      try {
+        fn();
+      } catch (...) {
+        std::lock_guard lock(mutex);
+        if (!error) {
+          error = std::current_exception();
+        }
+      }
+      finish_one();
+    });
+  }
+
+  void wait();
+
+private:
+  void finish_one();
+
+  ThreadPool &pool;
+  std::atomic<std::size_t> pending{0};
+  std::mutex mutex;
+  std::condition_variable done;
+  std::exception_ptr error;
+};
+
+template <typename Fn>
+void ThreadPool::parallel_for(std::size_t count, std::size_t min_per_task,
+                              const Fn &fn, std::size_t max_tasks) {
+  if (count == 0) {
+    return;
+  }
+  if (max_tasks == 0) {
+    max_tasks = std::size_t{4} * std::max(1u, size());
+  }
+  const std::size_t task_count = std::max<std::size_t>(
+      1, std::min(max_tasks, count / std::max<std::size_t>(1, min_per_task)));
+  if (task_count <= 1) {
+    fn(std::size_t{0}, count);
+    return;
+  }
+
+  const std::size_t chunk = (count + task_count - 1) / task_count;
+  TaskGroup group(*this);
+  for (std::size_t begin = chunk; begin < count; begin += chunk) {
+    const std::size_t end = std::min(count, begin + chunk);
+    group.run([&fn, begin, end]() { fn(begin, end); });
+  }
+  try {
+    fn(std::size_t{0}, std::min(count, chunk));
+  } catch (...) {
+    group.wait();
+    throw;
+  }
+  group.wait();
+}
\ No newline at end of file
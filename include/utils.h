@@ -1,5 +1,14 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
 
-std::vector<unsigned char> hex_to_ascii(const std::string &input);
\ No newline at end of file
+// Throws std::invalid_argument on odd-length or non-hex input.
+std::vector<unsigned char> hex_to_ascii(const std::string &input);
+
+// Differing bits / differing hex digits between two hex strings, ignoring
+// case. A digit present in only one string is compared against zero by
+// bit_diff and always counts for hex_diff. Both throw std::invalid_argument
+// on a non-hex character.
+int bit_diff(std::string_view hash1, std::string_view hash2);
+int hex_diff(std::string_view hash1, std::string_view hash2);
\ No newline at end of file
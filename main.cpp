@@ -3,20 +3,145 @@
 #include <FileRead.h>
 #include <FileWrite.h>
 #include <Hasher.h>
+#include <algorithm>
+#include <async_file_reader.h>
 #include <constants.h>
 #include <cstddef>
 #include <cstdint>
+#include <cstdlib>
+#include <digest_cache.h>
 #include <exception>
 #include <filesystem>
+#include <future>
+#include <hex.h>
 #include <iostream>
+#include <memory>
+#include <optional>
 #include <parsing_helper_funcs.h>
+#include <stage_profiler.h>
 #include <string>
 #include <test_file_generator.h>
+#include <thread_pool.h>
 #include <utils.h>
 #include <vector>
-const auto salt = "2a-sasdn021312==s";
+
+namespace {
+
+// $XDG_CACHE_HOME/hashf/digests, else ~/.cache/hashf/digests.
+std::optional<std::filesystem::path> default_cache_path() {
+  if (const char *xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+    return std::filesystem::path(xdg) / "hashf" / "digests";
+  }
+  if (const char *home = std::getenv("HOME"); home && *home) {
+    return std::filesystem::path(home) / ".cache" / "hashf" / "digests";
+  }
+  return std::nullopt;
+}
+
+std::vector<std::filesystem::path> collect_files(const std::filesystem::path &target) {
+  if (!std::filesystem::is_directory(target)) {
+    return {target};
+  }
+  std::vector<std::filesystem::path> files;
+  for (const auto &entry : std::filesystem::recursive_directory_iterator(target)) {
+    if (entry.is_regular_file()) {
+      files.push_back(entry.path());
+    }
+  }
+  std::sort(files.begin(), files.end());
+  return files;
+}
+
+// Hashes a file, or every file under a directory, with AIHasher. Files whose
+// identity is in the digest cache are not read at all; the rest are read
+// through AsyncFileReader and stored back if they did not change meanwhile.
+int hash_files(const std::filesystem::path &target,
+               const std::optional<std::filesystem::path> &cache_path) {
+  // The id is itself an AIHasher value, so changing the algorithm retires
+  // every cached digest.
+  constexpr std::uint64_t kAlgorithm = "ai"_ai64;
+  const AIHasher hasher;
+  const std::vector<std::filesystem::path> files = collect_files(target);
+
+  std::unique_ptr<DigestCache> cache;
+  if (cache_path) {
+    try {
+      cache = std::make_unique<DigestCache>(*cache_path);
+    } catch (const std::exception &e) {
+      std::cerr << "digest cache disabled: " << e.what() << '\n';
+    }
+  }
+
+  std::vector<FileIdentity> identities(files.size());
+  std::vector<DigestCache::Digest> digests(files.size());
+  std::vector<std::filesystem::path> to_read;
+  std::vector<std::size_t> read_index;
+  for (std::size_t i = 0; i < files.size(); ++i) {
+    identities[i] = file_identity(files[i]);
+    const auto cached = cache ? cache->find(identities[i], kAlgorithm) : std::nullopt;
+    if (cached) {
+      digests[i] = *cached;
+    } else {
+      to_read.push_back(files[i]);
+      read_index.push_back(i);
+    }
+  }
+
+  AsyncFileReader reader;
+  reader.read_all(to_read, [&](std::size_t k, std::string_view data) {
+    digests[read_index[k]] = hasher.digest<32>(data);
+  });
+
+  if (cache) {
+    std::vector<DigestCache::Record> records;
+    for (const std::size_t i : read_index) {
+      if (file_identity(files[i]) == identities[i]) {
+        records.push_back({identities[i], digests[i]});
+      }
+    }
+    cache->store(records, kAlgorithm);
+    std::cerr << "digest cache: " << cache->hits() << " hits, " << cache->misses()
+              << " misses\n";
+  }
+
+  if (files.size() == 1 && files.front() == target) {
+    std::cout << hex_encode(digests.front()) << std::endl;
+    return 0;
+  }
+  for (std::size_t i = 0; i < files.size(); ++i) {
+    std::cout << hex_encode(digests[i]) << "  "
+              << files[i].lexically_relative(target).string() << '\n';
+  }
+  return 0;
+}
+
+// --profile prints the per-stage table to stderr, --profile-json the same
+// counts as JSON.
+void report_stages(char **begin, char **end) {
+  const bool table = cmd_option_exists(begin, end, "--profile");
+  const bool json = cmd_option_exists(begin, end, "--profile-json");
+  if (!table && !json) {
+    return;
+  }
+  if (!stage_profiler::kEnabled) {
+    std::cerr << "stage profiling is compiled out; configure with "
+                 "-DHASHF_INSTRUMENT=ON\n";
+    return;
+  }
+  const auto totals = stage_profiler::report();
+  if (table) {
+    stage_profiler::write_table(std::cerr, totals);
+  }
+  if (json) {
+    stage_profiler::write_json(std::cerr, totals);
+  }
+}
+
+} // namespace
+
 int main(int argc, char *argv[]) {
   std::string input;
+  std::optional<std::string> salt;
   if (cmd_option_exists(argv, argv + argc, "generate")) {
     generators::write_empty_file(kEmptyFile);
     const auto size_pairs = std::vector<std::pair<int, int>>{
@@ -27,23 +152,51 @@ int main(int argc, char *argv[]) {
     std::cout << "Generating files with random symbols\n";
     generators::write_random_symbols(2000, 10, kRandomSymbolPath);
     std::cout << "Generated files with random symbols\n";
+    // Every pair file is independent; generate them on the shared pool and
+    // report completion in order.
+    ThreadPool &pool = ThreadPool::global();
+    std::vector<std::pair<std::string, std::future<void>>> jobs;
     for (auto [length, pair_count] : size_pairs) {
-      std::cout << "generating collision pairs of length " << length
-                << " and pair count of " << pair_count << '\n';
-      generators::write_collision_pairs(length, kTestDir / "collision",
-                                        pair_count);
-      std::cout << "Done!\n";
-      std::cout << "generating avalanche pairs of length " << length
-                << " and pair count of " << pair_count << '\n';
-      generators::write_avalanche_pairs(length, kTestDir / "avalanche",
-                                        pair_count);
+      jobs.emplace_back("collision pairs of length " + std::to_string(length) +
+                            " and pair count of " + std::to_string(pair_count),
+                        pool.submit([length, pair_count]() {
+                          generators::write_collision_pairs(
+                              length, kTestDir / "collision", pair_count);
+                        }));
+      jobs.emplace_back("avalanche pairs of length " + std::to_string(length) +
+                            " and pair count of " + std::to_string(pair_count),
+                        pool.submit([length, pair_count]() {
+                          generators::write_avalanche_pairs(
+                              length, kTestDir / "avalanche", pair_count);
+                        }));
+    }
+    for (auto &[description, job] : jobs) {
+      std::cout << "generating " << description << '\n';
+      job.get();
       std::cout << "Done!\n";
     }
     return 0;
   } else if (cmd_option_exists(argv, argv + argc, "--file")) {
     char *option = get_cmd_option(argv, argv + argc, "--file");
+    if (!option) {
+      std::cerr << "--file requires a path\n";
+      return 1;
+    }
+    std::optional<std::filesystem::path> cache_path = default_cache_path();
+    if (cmd_option_exists(argv, argv + argc, "--no-cache")) {
+      cache_path.reset();
+    } else if (cmd_option_exists(argv, argv + argc, "--cache")) {
+      char *cache_option = get_cmd_option(argv, argv + argc, "--cache");
+      if (!cache_option) {
+        std::cerr << "--cache requires a path\n";
+        return 1;
+      }
+      cache_path = cache_option;
+    }
     try {
-      input = ReadFile(std::filesystem::path(option));
+      const int status = hash_files(std::filesystem::path(option), cache_path);
+      report_stages(argv, argv + argc);
+      return status;
     } catch (std::exception &e) {
       std::cerr << e.what() << '\n';
       return 1;
@@ -56,15 +209,18 @@ int main(int argc, char *argv[]) {
       input = option;
     if (cmd_option_exists(argv, argv + argc, "--salt")) {
       char *option = get_cmd_option(argv, argv + argc, "--salt");
-      if (!option)
-        throw;
-      input += salt;
+      if (!option) {
+        std::cerr << "--salt requires a value\n";
+        return 1;
+      }
+      salt = option;
     }
   }
   if (argc == 1) {
     // add interactive input with menu
   }
-  AIHasher hasher;
+  const AIHasher hasher = salt ? AIHasher(*salt) : AIHasher();
   std::string output = hasher.hash256bit(input);
   std::cout << output << std::endl;
+  report_stages(argv, argv + argc);
 }
@@ -0,0 +1,356 @@
+#include <bench_results.h>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iterator>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+namespace {
+
+double median(std::vector<double> values) {
+  if (values.empty()) {
+    return 0.0;
+  }
+  const std::size_t mid = values.size() / 2;
+  std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(mid),
+                   values.end());
+  const double upper = values[mid];
+  if (values.size() % 2 == 1) {
+    return upper;
+  }
+  return (upper + *std::max_element(values.begin(),
+                                    values.begin() + static_cast<std::ptrdiff_t>(mid))) /
+         2.0;
+}
+
+void write_json_string(std::ostream &os, std::string_view value) {
+  os << '"';
+  for (const char c : value) {
+    if (c == '"' || c == '\\') {
+      os << '\\' << c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      os << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+         << static_cast<int>(c) << std::dec << std::setfill(' ');
+    } else {
+      os << c;
+    }
+  }
+  os << '"';
+}
+
+// Just enough JSON for the results files: objects are walked key by key and
+// values the caller does not ask for are skipped.
+class JsonReader {
+public:
+  explicit JsonReader(std::string input) : text(std::move(input)) {}
+
+  template <typename Fn> void object(Fn &&on_key) {
+    expect('{');
+    if (consume('}')) {
+      return;
+    }
+    do {
+      const std::string key = string();
+      expect(':');
+      on_key(key);
+    } while (consume(','));
+    expect('}');
+  }
+
+  template <typename Fn> void array(Fn &&on_item) {
+    expect('[');
+    if (consume(']')) {
+      return;
+    }
+    do {
+      on_item();
+    } while (consume(','));
+    expect(']');
+  }
+
+  std::string string() {
+    expect('"');
+    std::string out;
+    while (pos < text.size() && text[pos] != '"') {
+      char c = text[pos++];
+      if (c == '\\') {
+        if (pos >= text.size()) {
+          break;
+        }
+        c = text[pos++];
+        switch (c) {
+        case 'n':
+          c = '\n';
+          break;
+        case 't':
+          c = '\t';
+          break;
+        case 'r':
+          c = '\r';
+          break;
+        case 'b':
+          c = '\b';
+          break;
+        case 'f':
+          c = '\f';
+          break;
+        case 'u': {
+          if (pos + 4 > text.size()) {
+            fail("short \\u escape");
+          }
+          const unsigned long code =
+              std::strtoul(text.substr(pos, 4).c_str(), nullptr, 16);
+          pos += 4;
+          if (code > 0x7F) {
+            fail("non-ASCII \\u escape");
+          }
+          c = static_cast<char>(code);
+          break;
+        }
+        default:
+          break;
+        }
+      }
+      out.push_back(c);
+    }
+    expect('"');
+    return out;
+  }
+
+  double number() {
+    skip_space();
+    const char *begin = text.c_str() + pos;
+    char *end = nullptr;
+    const double value = std::strtod(begin, &end);
+    if (end == begin) {
+      fail("expected a number");
+    }
+    pos += static_cast<std::size_t>(end - begin);
+    return value;
+  }
+
+  void skip() {
+    skip_space();
+    if (pos >= text.size()) {
+      fail("unexpected end of input");
+    }
+    switch (text[pos]) {
+    case '{':
+      object([this](const std::string &) { skip(); });
+      break;
+    case '[':
+      array([this]() { skip(); });
+      break;
+    case '"':
+      string();
+      break;
+    case 't':
+    case 'f':
+    case 'n':
+      while (pos < text.size() && std::isalpha(static_cast<unsigned char>(text[pos]))) {
+        ++pos;
+      }
+      break;
+    default:
+      number();
+    }
+  }
+
+  void finish() {
+    skip_space();
+    if (pos != text.size()) {
+      fail("trailing characters");
+    }
+  }
+
+private:
+  void skip_space() {
+    while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) {
+      ++pos;
+    }
+  }
+
+  bool consume(char c) {
+    skip_space();
+    if (pos < text.size() && text[pos] == c) {
+      ++pos;
+      return true;
+    }
+    return false;
+  }
+
+  void expect(char c) {
+    if (!consume(c)) {
+      fail((std::string("expected '") + c + "'").c_str());
+    }
+  }
+
+  [[noreturn]] void fail(const char *what) const {
+    throw std::runtime_error("benchmark results: " + std::string(what) +
+                             " at offset " + std::to_string(pos));
+  }
+
+  std::string text;
+  std::size_t pos = 0;
+};
+
+} // namespace
+
+double BenchResult::ns_per_op() const { return median(samples_ns); }
+
+double BenchResult::stddev() const {
+  if (samples_ns.size() < 2) {
+    return 0.0;
+  }
+  double mean = 0.0;
+  for (const double s : samples_ns) {
+    mean += s;
+  }
+  mean /= static_cast<double>(samples_ns.size());
+  double squares = 0.0;
+  for (const double s : samples_ns) {
+    squares += (s - mean) * (s - mean);
+  }
+  return std::sqrt(squares / static_cast<double>(samples_ns.size() - 1));
+}
+
+void write_bench_json(std::ostream &os, const BenchRun &run) {
+  const auto flags = os.flags();
+  const auto precision = os.precision();
+  os << std::setprecision(std::numeric_limits<double>::max_digits10);
+  os << "{\n  \"commit\": ";
+  write_json_string(os, run.commit);
+  os << ",\n  \"results\": [";
+  for (std::size_t i = 0; i < run.results.size(); ++i) {
+    const BenchResult &r = run.results[i];
+    os << (i == 0 ? "\n    " : ",\n    ") << "{\"hasher\": ";
+    write_json_string(os, r.hasher);
+    os << ", \"size\": " << r.size << ", \"ns_per_op\": " << r.ns_per_op()
+       << ", \"stddev\": " << r.stddev() << ", \"samples\": [";
+    for (std::size_t s = 0; s < r.samples_ns.size(); ++s) {
+      os << (s == 0 ? "" : ", ") << r.samples_ns[s];
+    }
+    os << "]}";
+  }
+  os << (run.results.empty() ? "]\n}\n" : "\n  ]\n}\n");
+  os.flags(flags);
+  os.precision(precision);
+}
+
+BenchRun read_bench_json(std::istream &is) {
+  JsonReader reader(std::string(std::istreambuf_iterator<char>(is), {}));
+  BenchRun run;
+  reader.object([&](const std::string &key) {
+    if (key == "commit") {
+      run.commit = reader.string();
+    } else if (key == "results") {
+      reader.array([&]() {
+        BenchResult result;
+        reader.object([&](const std::string &field) {
+          if (field == "hasher") {
+            result.hasher = reader.string();
+          } else if (field == "size") {
+            result.size = static_cast<std::size_t>(reader.number());
+          } else if (field == "samples") {
+            reader.array([&]() { result.samples_ns.push_back(reader.number()); });
+          } else {
+            reader.skip();
+          }
+        });
+        if (result.samples_ns.empty()) {
+          throw std::runtime_error("benchmark results: '" + result.hasher +
+                                   "' at size " + std::to_string(result.size) +
+                                   " has no samples");
+        }
+        run.results.push_back(std::move(result));
+      });
+    } else {
+      reader.skip();
+    }
+  });
+  reader.finish();
+  return run;
+}
+
+MannWhitney mann_whitney_greater(std::span<const double> current,
+                                 std::span<const double> baseline) {
+  MannWhitney result;
+  const std::size_t n1 = current.size();
+  const std::size_t n2 = baseline.size();
+  if (n1 == 0 || n2 == 0) {
+    return result;
+  }
+
+  // (value, from current) sorted, then average ranks over runs of ties.
+  std::vector<std::pair<double, bool>> pooled;
+  pooled.reserve(n1 + n2);
+  for (const double v : current) {
+    pooled.emplace_back(v, true);
+  }
+  for (const double v : baseline) {
+    pooled.emplace_back(v, false);
+  }
+  std::sort(pooled.begin(), pooled.end());
+
+  const double n = static_cast<double>(n1 + n2);
+  double rank_sum = 0.0;
+  double tie_term = 0.0;
+  for (std::size_t i = 0; i < pooled.size();) {
+    std::size_t j = i;
+    while (j < pooled.size() && pooled[j].first == pooled[i].first) {
+      ++j;
+    }
+    const double rank = (static_cast<double>(i + 1) + static_cast<double>(j)) / 2.0;
+    for (std::size_t k = i; k < j; ++k) {
+      if (pooled[k].second) {
+        rank_sum += rank;
+      }
+    }
+    const double t = static_cast<double>(j - i);
+    tie_term += t * t * t - t;
+    i = j;
+  }
+
+  const double m1 = static_cast<double>(n1);
+  const double m2 = static_cast<double>(n2);
+  result.u = rank_sum - m1 * (m1 + 1.0) / 2.0;
+  const double mean = m1 * m2 / 2.0;
+  const double variance = m1 * m2 / 12.0 * ((n + 1.0) - tie_term / (n * (n - 1.0)));
+  if (variance <= 0.0) {
+    return result;
+  }
+  result.z = (result.u - mean - 0.5) / std::sqrt(variance);
+  result.p_value = 0.5 * std::erfc(result.z / std::sqrt(2.0));
+  return result;
+}
+
+std::vector<BenchComparison> compare_runs(const BenchRun &baseline,
+                                          const BenchRun &current, double alpha,
+                                          double min_slowdown) {
+  std::vector<BenchComparison> comparisons;
+  for (const BenchResult &now : current.results) {
+    const auto before = std::find_if(
+        baseline.results.begin(), baseline.results.end(),
+        [&](const BenchResult &r) { return r.hasher == now.hasher && r.size == now.size; });
+    if (before == baseline.results.end()) {
+      continue;
+    }
+    BenchComparison c;
+    c.hasher = now.hasher;
+    c.size = now.size;
+    c.baseline_ns = before->ns_per_op();
+    c.current_ns = now.ns_per_op();
+    c.change = c.baseline_ns > 0.0 ? c.current_ns / c.baseline_ns - 1.0 : 0.0;
+    c.p_value = mann_whitney_greater(now.samples_ns, before->samples_ns).p_value;
+    c.regression = c.p_value < alpha && c.change > min_slowdown;
+    comparisons.push_back(std::move(c));
+  }
+  return comparisons;
+}
\ No newline at end of file
@@ -0,0 +1,193 @@
+#include <crypto/AITreeHasher.h>
+#include <crypto/ai_hasher_detail.h>
+#include <hex.h>
+#include <thread_pool.h>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+namespace {
+
+using Digest = AITreeHasher::Digest;
+
+constexpr std::uint8_t kLeafFlag = 0x01U;
+constexpr std::uint8_t kParentFlag = 0x02U;
+constexpr std::uint8_t kRootFlag = 0x04U;
+constexpr std::size_t kMinLeavesPerWorker = 4;
+constexpr std::size_t kMinParentsPerWorker = 256;
+
+using Seed = ai_hasher_detail::Block;
+constexpr const Seed &kUnkeyed = ai_hasher_detail::kSeed;
+
+Digest compress_node(const Seed &seed, std::string_view data,
+                     std::uint64_t index, std::uint8_t flags) {
+  Seed block = seed;
+  block[0] ^= AITreeHasher::kVersion;
+  block[1] ^= flags;
+  const auto length = static_cast<std::uint64_t>(data.size());
+  for (std::size_t b = 0; b < 8; ++b) {
+    block[2 + b] ^= static_cast<std::uint8_t>(index >> (b * 8U));
+    block[10 + b] ^= static_cast<std::uint8_t>(length >> (b * 8U));
+  }
+  ai_hasher_detail::absorb_sequential(data, block);
+  return ai_hasher_detail::finalize(block);
+}
+
+Digest leaf_digest(const Seed &seed, std::string_view leaf, std::uint64_t index,
+                   bool root) {
+  return compress_node(seed, leaf, index,
+                       static_cast<std::uint8_t>(kLeafFlag | (root ? kRootFlag : 0U)));
+}
+
+Digest parent_digest(const Seed &seed, const Digest &left, const Digest &right,
+                     bool root) {
+  char children[64];
+  std::memcpy(children, left.data(), left.size());
+  std::memcpy(children + 32, right.data(), right.size());
+  return compress_node(seed, std::string_view(children, sizeof(children)), 0,
+                       static_cast<std::uint8_t>(kParentFlag | (root ? kRootFlag : 0U)));
+}
+
+std::size_t leaf_count(std::size_t size) {
+  return size == 0 ? 1 : (size + AITreeHasher::kLeafSize - 1) / AITreeHasher::kLeafSize;
+}
+
+std::string_view leaf_at(std::string_view data, std::size_t index) {
+  return data.substr(index * AITreeHasher::kLeafSize, AITreeHasher::kLeafSize);
+}
+
+std::vector<Digest> hash_leaves(const Seed &seed, std::string_view data,
+                                unsigned threads) {
+  const std::size_t count = leaf_count(data.size());
+  std::vector<Digest> leaves(count);
+  ThreadPool::global().parallel_for(
+      count, kMinLeavesPerWorker,
+      [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+          leaves[i] = leaf_digest(seed, leaf_at(data, i), i, count == 1);
+        }
+      },
+      threads);
+  return leaves;
+}
+
+std::vector<Digest> next_level(const Seed &seed,
+                               const std::vector<Digest> &level,
+                               unsigned threads) {
+  std::vector<Digest> parents((level.size() + 1) / 2);
+  const bool root = parents.size() == 1;
+  ThreadPool::global().parallel_for(
+      level.size() / 2, kMinParentsPerWorker,
+      [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+          parents[i] =
+              parent_digest(seed, level[2 * i], level[2 * i + 1], root);
+        }
+      },
+      threads);
+  if (level.size() % 2 == 1) {
+    parents.back() = level.back();
+  }
+  return parents;
+}
+
+} // namespace
+
+std::string AITreeHasher::hash256bit(const std::string &input) const {
+  const Digest root = digest(input);
+  return hex_encode(root);
+}
+
+AITreeHasher::AITreeHasher(std::string_view key, unsigned thread_count)
+    : threads(thread_count), seed(ai_hasher_detail::keyed_seed_block(key)) {}
+
+std::unique_ptr<IHasher> AITreeHasher::keyed(std::string_view key) const {
+  return std::make_unique<AITreeHasher>(key, threads);
+}
+
+AITreeHasher::Digest AITreeHasher::digest(std::string_view input) const {
+  std::vector<Digest> level = hash_leaves(seed, input, threads);
+  while (level.size() > 1) {
+    level = next_level(seed, level, threads);
+  }
+  return level.front();
+}
+
+void AITreeHasher::Stream::update(std::string_view data) {
+  while (!data.empty()) {
+    if (pending.size() == kLeafSize) {
+      Digest cv = leaf_digest(kUnkeyed, pending, leaves_done, false);
+      pending.clear();
+      ++leaves_done;
+      for (std::uint64_t total = leaves_done; (total & 1U) == 0; total >>= 1U) {
+        cv = parent_digest(kUnkeyed, stack.back(), cv, false);
+        stack.pop_back();
+      }
+      stack.push_back(cv);
+    }
+    const std::size_t take = std::min(kLeafSize - pending.size(), data.size());
+    pending.append(data.substr(0, take));
+    data.remove_prefix(take);
+  }
+}
+
+AITreeHasher::Digest AITreeHasher::Stream::finalize() const {
+  if (stack.empty()) {
+    return leaf_digest(kUnkeyed, pending, 0, true);
+  }
+  Digest cv = leaf_digest(kUnkeyed, pending, leaves_done, false);
+  for (std::size_t i = stack.size(); i-- > 0;) {
+    cv = parent_digest(kUnkeyed, stack[i], cv, i == 0);
+  }
+  return cv;
+}
+
+AITreeHasher::Incremental::Incremental(std::string_view data,
+                                       unsigned thread_count)
+    : size(data.size()) {
+  levels.push_back(hash_leaves(kUnkeyed, data, thread_count));
+  while (levels.back().size() > 1) {
+    levels.push_back(next_level(kUnkeyed, levels.back(), thread_count));
+  }
+}
+
+void AITreeHasher::Incremental::update(std::string_view data,
+                                       std::size_t offset, std::size_t length) {
+  if (data.size() != size) {
+    throw std::invalid_argument("incremental tree update must keep the input size");
+  }
+  if (length == 0) {
+    return;
+  }
+  if (offset > size || length > size - offset) {
+    throw std::out_of_range("incremental tree update range past end of input");
+  }
+
+  std::size_t first = offset / kLeafSize;
+  std::size_t last = (offset + length - 1) / kLeafSize;
+  const bool single_leaf = levels.front().size() == 1;
+  for (std::size_t i = first; i <= last; ++i) {
+    levels.front()[i] =
+        leaf_digest(kUnkeyed, leaf_at(data, i), i, single_leaf);
+  }
+  for (std::size_t level = 1; level < levels.size(); ++level) {
+    first /= 2;
+    last /= 2;
+    for (std::size_t i = first; i <= last; ++i) {
+      rebuild_parent(level, i);
+    }
+  }
+}
+
+void AITreeHasher::Incremental::rebuild_parent(std::size_t level,
+                                               std::size_t index) {
+  const std::vector<Digest> &children = levels[level - 1];
+  if (2 * index + 1 < children.size()) {
+    levels[level][index] = parent_digest(kUnkeyed, children[2 * index],
+                                         children[2 * index + 1],
+                                         levels[level].size() == 1);
+  } else {
+    levels[level][index] = children[2 * index];
+  }
+}
\ No newline at end of file
@@ -1,10 +1,15 @@
 #include <crypto/Hasher.h>
+#include <hex.h>
+#include <stage_profiler.h>
 #include <bitset>
+#include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 #include <list>
+#include <memory>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
 union consts {
@@ -13,24 +18,6 @@ union consts {
   uint8_t bytes[64];
   uint64_t blocks[8];
 } consts;
-std::string to_string(const std::vector<uint8_t> &bytes) {
-  std::string res;
-  for (unsigned char c : bytes) {
-    res += (char)c;
-  }
-  return res;
-}
-std::string to_hex(const std::string &text) {
-  const char abecele[] = "0123456789abcdef";
-  std::string res;
-  for (unsigned char byte : text) {
-    int pirmas = (byte >> 4) & 0x0F;
-    int antras = byte & 0x0F;
-    res += abecele[pirmas % 16];
-    res += abecele[antras % 16];
-  }
-  return res;
-}
 inline uint8_t uint8_t_xor_rotate(uint8_t a, uint8_t b) {
   b = b % 8;
   if (b == 0)
@@ -80,10 +67,12 @@ public:
   void reset() { count = 0; }
 };
 const std::string xor_key = "ARCHAS MATUOLIS";
-PeriodicCounter pc(5);
 
 void collapse(std::vector<uint8_t> &bytes, int collapseSize) {
-  pc.reset();
+  const stage_profiler::StageTimer timer(stage_profiler::Stage::asmeninis_collapse);
+  // Local so concurrent hashes do not share the counter; it started from 0
+  // on every call before, so digests are unchanged.
+  PeriodicCounter pc(5);
   if (collapseSize == 0 || bytes.size() <= collapseSize)
     throw std::runtime_error("blogas collapse dydis");
   std::list<uint8_t> excess(bytes.begin() + collapseSize, bytes.end());
@@ -129,20 +118,45 @@ std::string to_binary_str(const std::vector<uint8_t> bytes) {
   }
   return res;
 }
-std::string Hasher::hash256bit(const std::string &input) const {
-  std::vector<uint8_t> block(consts.bytes, consts.bytes + 64);
-  if (input.size() > 0) {
-    for (int i = 0; i < input.size(); i++) {
-      size_t idx = i % block.size();
-      block[idx] ^= static_cast<uint8_t>(input[i]);
-      block[(idx + 11) % block.size()] ^=
-          uint8_t_xor_rotate(input[i] + i, (i * 13) & 0xc5);
-    }
+void absorb(std::vector<uint8_t> &block, std::string_view input) {
+  const stage_profiler::StageTimer timer(stage_profiler::Stage::asmeninis_absorb);
+  for (int i = 0; i < input.size(); i++) {
+    size_t idx = i % block.size();
+    block[idx] ^= static_cast<uint8_t>(input[i]);
+    block[(idx + 11) % block.size()] ^=
+        uint8_t_xor_rotate(input[i] + i, (i * 13) & 0xc5);
   }
+}
+void diffuse(std::vector<uint8_t> &block) {
+  const stage_profiler::StageTimer timer(stage_profiler::Stage::asmeninis_diffuse);
   for (int i = 0; i < block.size() - 1; i++) {
     block[i] = block[i] ^ xor_key[i % xor_key.size()];
     block[i + 1] = (block[i + 1] << 4) | (block[i] + i) % 256;
   }
+}
+// diffuse() drops bits, so a key absorbed straight into the seed would
+// survive only partially; spread the key's own 32-byte digest over the whole
+// seed instead.
+Hasher::Hasher(std::string_view key)
+    : key_seed(consts.bytes, consts.bytes + 64) {
+  std::vector<uint8_t> digest(consts.bytes, consts.bytes + 64);
+  absorb(digest, key);
+  diffuse(digest);
+  collapse(digest, 32);
+  for (std::size_t i = 0; i < key_seed.size(); i++) {
+    key_seed[i] ^= digest[i % digest.size()] ^ (i < 32 ? 0x00 : 0x4B);
+  }
+}
+std::unique_ptr<IHasher> Hasher::keyed(std::string_view key) const {
+  return std::make_unique<Hasher>(key);
+}
+std::string Hasher::hash256bit(const std::string &input) const {
+  std::vector<uint8_t> block =
+      key_seed.empty() ? std::vector<uint8_t>(consts.bytes, consts.bytes + 64)
+                       : key_seed;
+  absorb(block, input);
+  diffuse(block);
   collapse(block, 32);
-  return to_hex(to_string(block));
+  const stage_profiler::StageTimer timer(stage_profiler::Stage::asmeninis_to_hex);
+  return hex_encode(block);
 }
\ No newline at end of file
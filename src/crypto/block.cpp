@@ -0,0 +1,68 @@
+#include <crypto/AIHasher.h>
+#include <crypto/block.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+const AIHasher &block_hasher() {
+  static const AIHasher hasher;
+  return hasher;
+}
+
+} // namespace
+
+Block::Block(const std::vector<Transaction> &transactions,
+             const std::string &previous_block_hash, int dificulty)
+    : _previous_block_hash(previous_block_hash), _transactions(transactions),
+      _timestamp(std::time(nullptr)), _nonce(0), _dificulty(dificulty) {
+  _block_hash = to_hash();
+}
+
+std::string Block::mine_block() {
+  _block_hash = to_hash();
+  while (!meets_difficulty(_block_hash, _dificulty)) {
+    ++_nonce;
+    _block_hash = to_hash();
+  }
+  return _block_hash;
+}
+
+std::string Block::to_hash() const {
+  return compute_hash(_previous_block_hash, _timestamp, _nonce, _dificulty,
+                      _transactions);
+}
+
+std::string Block::compute_hash(const std::string &previous_block_hash,
+                                std::time_t timestamp, int nonce, int dificulty,
+                                std::span<const Transaction> transactions) {
+  std::string payload;
+  payload.reserve(previous_block_hash.size() + 48U + transactions.size() * 65U);
+  payload.append(previous_block_hash);
+  payload.push_back(':');
+  payload.append(std::to_string(timestamp));
+  payload.push_back(':');
+  payload.append(std::to_string(nonce));
+  payload.push_back(':');
+  payload.append(std::to_string(dificulty));
+  for (const auto &transaction : transactions) {
+    payload.push_back(':');
+    payload.append(transaction.txid);
+  }
+  return block_hasher().hash256bit(payload);
+}
+
+bool Block::meets_difficulty(const std::string &hash, int dificulty) {
+  if (dificulty <= 0) {
+    return true;
+  }
+  if (hash.size() < static_cast<std::size_t>(dificulty)) {
+    return false;
+  }
+  for (int i = 0; i < dificulty; ++i) {
+    if (hash[static_cast<std::size_t>(i)] != '0') {
+      return false;
+    }
+  }
+  return true;
+}
\ No newline at end of file
@@ -0,0 +1,231 @@
+#include <crypto/blockchain.h>
+#include <thread_pool.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iterator>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t kValidationBatch = 64;
+constexpr auto kProgressInterval = std::chrono::milliseconds(100);
+constexpr std::size_t kNoInvalidBlock = std::numeric_limits<std::size_t>::max();
+
+void record_invalid(std::atomic<std::size_t> &first_invalid, std::size_t height) {
+  std::size_t current = first_invalid.load(std::memory_order_relaxed);
+  while (height < current &&
+         !first_invalid.compare_exchange_weak(current, height,
+                                              std::memory_order_relaxed)) {
+  }
+}
+
+} // namespace
+
+Blockchain::Blockchain(std::unique_ptr<Block> root) {
+  if (!root) {
+    throw std::invalid_argument("blockchain root block must not be null");
+  }
+  if (!verify_transactions(*root)) {
+    throw std::invalid_argument("invalid root block: " + verification.reason);
+  }
+  auto txs = root->take_transactions();
+  append(*root, std::make_move_iterator(txs.begin()),
+         std::make_move_iterator(txs.end()));
+}
+
+Blockchain::Blockchain(const Block &root) {
+  if (!verify_transactions(root)) {
+    throw std::invalid_argument("invalid root block: " + verification.reason);
+  }
+  append(root, root.transactions().begin(), root.transactions().end());
+}
+
+Blockchain::Blockchain(Block &&root) {
+  if (!verify_transactions(root)) {
+    throw std::invalid_argument("invalid root block: " + verification.reason);
+  }
+  auto txs = root.take_transactions();
+  append(root, std::make_move_iterator(txs.begin()),
+         std::make_move_iterator(txs.end()));
+}
+
+bool Blockchain::add_block(std::unique_ptr<Block> block) {
+  if (!block) {
+    return false;
+  }
+  return add_block(std::move(*block));
+}
+
+bool Blockchain::add_block(const Block &block) {
+  if (!links_to_tip(block) || !verify_transactions(block)) {
+    return false;
+  }
+  append(block, block.transactions().begin(), block.transactions().end());
+  return true;
+}
+
+bool Blockchain::add_block(Block &&block) {
+  if (!links_to_tip(block) || !verify_transactions(block)) {
+    return false;
+  }
+  auto txs = block.take_transactions();
+  append(block, std::make_move_iterator(txs.begin()),
+         std::make_move_iterator(txs.end()));
+  return true;
+}
+
+void Blockchain::pop_block() {
+  if (blocks.size() <= 1) {
+    throw std::logic_error("cannot pop the root block");
+  }
+  const BlockRecord &record = blocks.back();
+  heights.erase(record.block_hash);
+  const auto txs = record.transactions;
+  blocks.pop_back();
+  transactions.pop_run(txs);
+  balance_index.rollback_block();
+}
+
+const BlockRecord &Blockchain::at(std::size_t height) const {
+  if (height >= blocks.size()) {
+    std::ostringstream msg;
+    msg << "block height " << height << " out of range (chain size "
+        << blocks.size() << ")";
+    throw std::out_of_range(msg.str());
+  }
+  return blocks[height];
+}
+
+std::optional<std::size_t>
+Blockchain::find(std::string_view block_hash) const {
+  const auto it = heights.find(block_hash);
+  if (it == heights.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+ValidationResult Blockchain::validate(const ValidationProgress &progress,
+                                      unsigned thread_count) const {
+  const std::size_t total = blocks.size();
+
+  // Linkage is cheap and sequential; it bounds how far the hashing pass
+  // has to go before an earlier failure makes later blocks irrelevant.
+  std::size_t link_failure = kNoInvalidBlock;
+  for (std::size_t h = 1; h < total; ++h) {
+    if (blocks[h].previous_block_hash != blocks[h - 1].block_hash) {
+      link_failure = h;
+      break;
+    }
+  }
+
+  std::atomic<std::size_t> first_invalid{link_failure};
+  std::atomic<std::size_t> next{0};
+  std::atomic<std::size_t> validated{0};
+
+  // Validates one claimed batch; false once there is nothing left to do.
+  auto run_batch = [&]() {
+    const std::size_t begin =
+        next.fetch_add(kValidationBatch, std::memory_order_relaxed);
+    if (begin >= total ||
+        begin >= first_invalid.load(std::memory_order_relaxed)) {
+      return false;
+    }
+    const std::size_t end = std::min(total, begin + kValidationBatch);
+    for (std::size_t h = begin; h < end; ++h) {
+      const BlockRecord &record = blocks[h];
+      const std::string hash =
+          Block::compute_hash(record.previous_block_hash, record.timestamp,
+                              record.nonce, record.difficulty,
+                              record.transactions);
+      if (hash != record.block_hash ||
+          !Block::meets_difficulty(hash, record.difficulty)) {
+        record_invalid(first_invalid, h);
+        break;
+      }
+    }
+    validated.fetch_add(end - begin, std::memory_order_relaxed);
+    return true;
+  };
+
+  ThreadPool &pool = ThreadPool::global();
+  const std::size_t worker_count = std::max<std::size_t>(
+      1, std::min<std::size_t>(thread_count == 0 ? pool.size() : thread_count,
+                               total / kValidationBatch + 1));
+
+  // The calling thread is one of the workers and reports progress between
+  // its own batches.
+  TaskGroup group(pool);
+  for (std::size_t i = 1; i < worker_count; ++i) {
+    group.run([&run_batch]() {
+      while (run_batch()) {
+      }
+    });
+  }
+  auto last_report = std::chrono::steady_clock::now();
+  while (run_batch()) {
+    const auto now = std::chrono::steady_clock::now();
+    if (progress && now - last_report >= kProgressInterval) {
+      progress(std::min(validated.load(), total), total);
+      last_report = now;
+    }
+  }
+  group.wait();
+
+  ValidationResult result;
+  const std::size_t invalid = first_invalid.load();
+  if (invalid != kNoInvalidBlock) {
+    const BlockRecord &record = blocks[invalid];
+    result.valid = false;
+    result.first_invalid_height = invalid;
+    if (invalid == link_failure) {
+      result.reason = "previous block hash does not match";
+    } else if (Block::compute_hash(record.previous_block_hash,
+                                   record.timestamp, record.nonce,
+                                   record.difficulty,
+                                   record.transactions) != record.block_hash) {
+      result.reason = "block hash does not match contents";
+    } else {
+      result.reason = "block hash does not meet difficulty";
+    }
+  }
+  if (progress) {
+    progress(result.valid ? total : invalid, total);
+  }
+  return result;
+}
+
+bool Blockchain::links_to_tip(const Block &block) const {
+  return block.previous_block_hash() == blocks.back().block_hash &&
+         !heights.contains(block.block_hash());
+}
+
+bool Blockchain::verify_transactions(const Block &block) {
+  verification = verifier.verify(block.transactions(), balance_index);
+  return verification.valid;
+}
+
+template <typename It>
+void Blockchain::append(const Block &block, It first, It last) {
+  const auto txs = transactions.append(first, last);
+  try {
+    const std::size_t height = blocks.emplace_back(
+        BlockRecord{block.previous_block_hash(), block.block_hash(),
+                    block.timestamp(), block.nonce(), block.difficulty(), txs});
+    try {
+      heights.emplace(blocks[height].block_hash, height);
+    } catch (...) {
+      blocks.pop_back();
+      throw;
+    }
+  } catch (...) {
+    transactions.pop_run(txs);
+    balance_index.rollback_block();
+    throw;
+  }
+}
\ No newline at end of file
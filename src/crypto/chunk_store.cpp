@@ -0,0 +1,197 @@
+#include <crypto/chunk_store.h>
+#include <crypto/hasher_registry.h>
+#include <thread_pool.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+namespace {
+
+constexpr std::size_t kStreamBuffer = std::size_t{16} << 20U;
+constexpr std::size_t kMinChunksPerTask = 8;
+
+std::string read_text(const std::filesystem::path &path) {
+  std::ifstream in(path);
+  std::string text;
+  std::getline(in, text);
+  return text;
+}
+
+void write_object(const std::filesystem::path &target, std::string_view bytes) {
+  std::filesystem::create_directories(target.parent_path());
+  std::filesystem::path temporary = target;
+  temporary += ".tmp";
+  {
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    if (!out) {
+      throw std::runtime_error("failed to write chunk '" + temporary.string() + "'");
+    }
+  }
+  std::filesystem::rename(temporary, target);
+}
+
+} // namespace
+
+ChunkStore::ChunkStore(std::filesystem::path root_dir, std::string_view hasher_name,
+                       ChunkerParams params)
+    : root(std::move(root_dir)), hasher(HasherRegistry::make(hasher_name)),
+      cutter(params) {
+  std::filesystem::create_directories(root / "objects");
+  const std::filesystem::path hasher_file = root / "hasher";
+  if (std::filesystem::exists(hasher_file)) {
+    const std::string recorded = read_text(hasher_file);
+    if (recorded != hasher_name) {
+      throw std::invalid_argument("chunk store '" + root.string() + "' uses hasher '" +
+                                  recorded + "', not '" + std::string(hasher_name) +
+                                  "'");
+    }
+  } else {
+    std::ofstream(hasher_file) << hasher_name << '\n';
+  }
+
+  for (const auto &entry :
+       std::filesystem::recursive_directory_iterator(root / "objects")) {
+    if (!entry.is_regular_file() || entry.path().extension() == ".tmp") {
+      continue;
+    }
+    const std::string digest = entry.path().parent_path().filename().string() +
+                               entry.path().filename().string();
+    index.insert_or_assign(digest, static_cast<std::uint32_t>(entry.file_size()));
+  }
+}
+
+std::filesystem::path ChunkStore::object_path(std::string_view digest) const {
+  return root / "objects" / std::string(digest.substr(0, 2)) /
+         std::string(digest.substr(2));
+}
+
+// Chunks are hashed in parallel, deduplicated in order against the index and
+// the batch itself, and the new ones written in parallel. They enter the index
+// only once every write has succeeded, so a failed put leaves no names behind
+// that have no object.
+void ChunkStore::put_chunks(std::string_view data,
+                            const std::vector<std::size_t> &lengths,
+                            Manifest &manifest, PutStats &stats) {
+  std::vector<std::size_t> offsets(lengths.size());
+  for (std::size_t i = 1; i < lengths.size(); ++i) {
+    offsets[i] = offsets[i - 1] + lengths[i - 1];
+  }
+
+  std::vector<std::string> digests(lengths.size());
+  ThreadPool::global().parallel_for(
+      lengths.size(), kMinChunksPerTask, [&](std::size_t begin, std::size_t end) {
+        std::string chunk;
+        for (std::size_t i = begin; i < end; ++i) {
+          chunk.assign(data.substr(offsets[i], lengths[i]));
+          digests[i] = hasher->hash256bit(chunk);
+        }
+      });
+
+  std::vector<std::size_t> fresh;
+  FlatStringMap<std::uint32_t> batch(lengths.size());
+  for (std::size_t i = 0; i < lengths.size(); ++i) {
+    const auto size = static_cast<std::uint32_t>(lengths[i]);
+    if (!index.contains(digests[i]) && batch.try_emplace(digests[i], size).second) {
+      fresh.push_back(i);
+      stats.new_bytes += size;
+    }
+    stats.bytes += size;
+    manifest.size += size;
+    manifest.chunks.push_back({std::move(digests[i]), size});
+  }
+  stats.chunks += lengths.size();
+  stats.new_chunks += fresh.size();
+
+  const std::size_t first = manifest.chunks.size() - lengths.size();
+  ThreadPool::global().parallel_for(
+      fresh.size(), kMinChunksPerTask, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t f = begin; f < end; ++f) {
+          const std::size_t i = fresh[f];
+          write_object(object_path(manifest.chunks[first + i].digest),
+                       data.substr(offsets[i], lengths[i]));
+        }
+      });
+  for (const std::size_t i : fresh) {
+    index.insert_or_assign(manifest.chunks[first + i].digest,
+                           manifest.chunks[first + i].size);
+  }
+}
+
+Manifest ChunkStore::put(std::string_view data, PutStats *stats) {
+  Manifest manifest;
+  PutStats local;
+  put_chunks(data, cutter.split(data), manifest, local);
+  if (stats) {
+    *stats = local;
+  }
+  return manifest;
+}
+
+Manifest ChunkStore::put(std::istream &input, PutStats *stats) {
+  Manifest manifest;
+  PutStats local;
+  std::string buffer(std::max(kStreamBuffer, 2 * cutter.params().max_size), '\0');
+  std::size_t filled = 0;
+  bool eof = false;
+  while (true) {
+    while (!eof && filled < buffer.size()) {
+      input.read(buffer.data() + filled,
+                 static_cast<std::streamsize>(buffer.size() - filled));
+      filled += static_cast<std::size_t>(input.gcount());
+      eof = !input;
+    }
+    if (input.bad()) {
+      throw std::runtime_error("failed to read chunk store input");
+    }
+
+    // Without the end of input in sight, only cut where a full max_size
+    // window is buffered so the boundaries match put(string_view).
+    const std::string_view pending(buffer.data(), filled);
+    std::vector<std::size_t> lengths;
+    std::size_t used = 0;
+    while (used < filled && (eof || filled - used >= cutter.params().max_size)) {
+      lengths.push_back(cutter.cut(pending.substr(used)));
+      used += lengths.back();
+    }
+    put_chunks(pending.substr(0, used), lengths, manifest, local);
+
+    std::memmove(buffer.data(), buffer.data() + used, filled - used);
+    filled -= used;
+    if (eof) {
+      break;
+    }
+  }
+  if (stats) {
+    *stats = local;
+  }
+  return manifest;
+}
+
+std::string ChunkStore::read_chunk(const ChunkRef &chunk) const {
+  const std::filesystem::path path = object_path(chunk.digest);
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    throw std::runtime_error("chunk '" + chunk.digest + "' is missing");
+  }
+  std::string data(chunk.size, '\0');
+  in.read(data.data(), static_cast<std::streamsize>(data.size()));
+  if (static_cast<std::size_t>(in.gcount()) != data.size() || in.peek() != EOF ||
+      hasher->hash256bit(data) != chunk.digest) {
+    throw std::runtime_error("chunk '" + chunk.digest + "' is corrupt");
+  }
+  return data;
+}
+
+void ChunkStore::restore(const Manifest &manifest, std::ostream &out) const {
+  for (const ChunkRef &chunk : manifest.chunks) {
+    const std::string data = read_chunk(chunk);
+    out.write(data.data(), static_cast<std::streamsize>(data.size()));
+  }
+  if (!out) {
+    throw std::runtime_error("failed to write restored stream");
+  }
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#include <crypto/chunker.h>
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+namespace {
+
+// The top `bits` bits: the low bits of a Gear fingerprint only see the last
+// few bytes, the high ones the full 64-byte window.
+std::uint64_t top_bits(unsigned bits) {
+  return bits == 0 ? 0 : ~std::uint64_t{0} << (64U - bits);
+}
+
+} // namespace
+
+Chunker::Chunker(ChunkerParams params) : config(params) {
+  if (config.min_size == 0 || config.min_size > config.avg_size ||
+      config.avg_size > config.max_size || !std::has_single_bit(config.avg_size)) {
+    throw std::invalid_argument(
+        "chunker sizes must satisfy 0 < min <= avg <= max with avg a power of two");
+  }
+  const auto bits = static_cast<unsigned>(std::countr_zero(config.avg_size));
+  mask_small = top_bits(bits + 2U);
+  mask_large = top_bits(bits > 2U ? bits - 2U : 0U);
+}
+
+std::size_t Chunker::cut(std::string_view data) const {
+  const std::size_t size = data.size();
+  if (size <= config.min_size) {
+    return size;
+  }
+  const auto *bytes = reinterpret_cast<const unsigned char *>(data.data());
+  const std::size_t normal = std::min(config.avg_size, size);
+  const std::size_t limit = std::min(config.max_size, size);
+
+  std::uint64_t fingerprint = 0;
+  std::size_t i = config.min_size;
+  for (; i < normal; ++i) {
+    fingerprint = (fingerprint << 1U) + kGear[bytes[i]];
+    if ((fingerprint & mask_small) == 0) {
+      return i + 1;
+    }
+  }
+  for (; i < limit; ++i) {
+    fingerprint = (fingerprint << 1U) + kGear[bytes[i]];
+    if ((fingerprint & mask_large) == 0) {
+      return i + 1;
+    }
+  }
+  return limit;
+}
+
+std::vector<std::size_t> Chunker::split(std::string_view data) const {
+  std::vector<std::size_t> lengths;
+  lengths.reserve(data.size() / config.avg_size + 1);
+  while (!data.empty()) {
+    const std::size_t length = cut(data);
+    lengths.push_back(length);
+    data.remove_prefix(length);
+  }
+  return lengths;
+}
\ No newline at end of file
@@ -0,0 +1,125 @@
+#include <crypto/mempool.h>
+#include <algorithm>
+#include <bit>
+#include <utility>
+
+Mempool::Mempool(std::size_t capacity) : max_size(capacity) {
+  by_txid.reserve(capacity);
+}
+
+bool Mempool::add(Transaction transaction, std::uint64_t fee) {
+  if (max_size == 0 || by_txid.contains(transaction.txid)) {
+    return false;
+  }
+  const std::uint32_t bucket = bucket_for(fee);
+  if (size() >= max_size) {
+    const std::uint32_t lowest = lowest_bucket();
+    if (bucket <= lowest) {
+      return false;
+    }
+    erase_slot(buckets[lowest].head);
+    ++evicted;
+  }
+
+  std::uint32_t slot;
+  if (!free_slots.empty()) {
+    slot = free_slots.back();
+    free_slots.pop_back();
+    entries[slot] = Entry{std::move(transaction), fee, bucket};
+  } else {
+    slot = static_cast<std::uint32_t>(
+        entries.emplace_back(Entry{std::move(transaction), fee, bucket}));
+  }
+  link(slot);
+  by_txid.emplace(entries[slot].transaction.txid, slot);
+  return true;
+}
+
+bool Mempool::remove(std::string_view txid) {
+  const auto it = by_txid.find(txid);
+  if (it == by_txid.end()) {
+    return false;
+  }
+  erase_slot(it->second);
+  return true;
+}
+
+void Mempool::remove_included(std::span<const Transaction> transactions) {
+  for (const auto &transaction : transactions) {
+    remove(transaction.txid);
+  }
+}
+
+std::vector<Transaction>
+Mempool::build_template(std::size_t max_transactions) const {
+  std::vector<Transaction> result;
+  result.reserve(std::min(max_transactions, size()));
+  std::array<std::uint64_t, 2> pending = occupied;
+  while (result.size() < max_transactions && (pending[0] | pending[1]) != 0) {
+    const std::uint32_t bucket =
+        pending[1] != 0 ? 64U
+                        : 63U - static_cast<std::uint32_t>(
+                                    std::countl_zero(pending[0]));
+    pending[bucket >> 6U] &= ~(std::uint64_t{1} << (bucket & 63U));
+    for (std::uint32_t slot = buckets[bucket].head;
+         slot != kNone && result.size() < max_transactions;
+         slot = entries[slot].next) {
+      result.push_back(entries[slot].transaction);
+    }
+  }
+  return result;
+}
+
+std::uint32_t Mempool::bucket_for(std::uint64_t fee) {
+  return 64U - static_cast<std::uint32_t>(std::countl_zero(fee));
+}
+
+std::uint32_t Mempool::lowest_bucket() const {
+  if (occupied[0] != 0) {
+    return static_cast<std::uint32_t>(std::countr_zero(occupied[0]));
+  }
+  if (occupied[1] != 0) {
+    return 64U;
+  }
+  return kNone;
+}
+
+void Mempool::link(std::uint32_t slot) {
+  Entry &entry = entries[slot];
+  Bucket &bucket = buckets[entry.bucket];
+  entry.prev = bucket.tail;
+  entry.next = kNone;
+  if (bucket.tail != kNone) {
+    entries[bucket.tail].next = slot;
+  } else {
+    bucket.head = slot;
+    occupied[entry.bucket >> 6U] |= std::uint64_t{1} << (entry.bucket & 63U);
+  }
+  bucket.tail = slot;
+}
+
+void Mempool::unlink(std::uint32_t slot) {
+  Entry &entry = entries[slot];
+  Bucket &bucket = buckets[entry.bucket];
+  if (entry.prev != kNone) {
+    entries[entry.prev].next = entry.next;
+  } else {
+    bucket.head = entry.next;
+  }
+  if (entry.next != kNone) {
+    entries[entry.next].prev = entry.prev;
+  } else {
+    bucket.tail = entry.prev;
+  }
+  if (bucket.head == kNone) {
+    occupied[entry.bucket >> 6U] &= ~(std::uint64_t{1} << (entry.bucket & 63U));
+  }
+  entry.prev = entry.next = kNone;
+}
+
+void Mempool::erase_slot(std::uint32_t slot) {
+  by_txid.erase(entries[slot].transaction.txid);
+  unlink(slot);
+  entries[slot].transaction = Transaction{};
+  free_slots.push_back(slot);
+}
\ No newline at end of file
@@ -1,44 +1,136 @@
 #include <crypto/sha256_hasher.h>
+#include <hex.h>
+#include <algorithm>
 #include <openssl/err.h>
 #include <openssl/evp.h>
+#include <stdexcept>
 
-std::string SHA256_Hasher::hash256bit(const std::string &input) const {
-  const EVP_MD *md = EVP_sha256();
-  if (!md) {
-    return {};
-  }
+namespace {
 
-  EVP_MD_CTX *mdctx = EVP_MD_CTX_new();
-  if (!mdctx) {
-    return {};
+constexpr std::size_t kBlockSize = 64;
+
+const EVP_MD *sha256_md() {
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+  // Explicit fetch: EVP_sha256() would repeat the provider lookup inside
+  // every EVP_DigestInit_ex call. Never freed, like the context below.
+  static EVP_MD *md = EVP_MD_fetch(nullptr, "SHA256", nullptr);
+  return md;
+#else
+  return EVP_sha256();
+#endif
+}
+
+struct ContextDeleter {
+  void operator()(EVP_MD_CTX *ctx) const { EVP_MD_CTX_free(ctx); }
+};
+using Context = std::unique_ptr<EVP_MD_CTX, ContextDeleter>;
+
+EVP_MD_CTX *thread_context() {
+  thread_local Context ctx(EVP_MD_CTX_new());
+  return ctx.get();
+}
+
+// Not EVP_Digest: the one-shot call allocates a context per message and is
+// slower than re-initialising this one (see "benchmark sha256").
+bool plain_digest(std::string_view input, unsigned char *out) {
+  EVP_MD_CTX *ctx = thread_context();
+  const EVP_MD *md = sha256_md();
+  if (!ctx || !md) {
+    return false;
   }
+  unsigned int md_len = 0;
+  return 1 == EVP_DigestInit_ex(ctx, md, nullptr) &&
+         1 == EVP_DigestUpdate(ctx, input.data(), input.size()) &&
+         1 == EVP_DigestFinal_ex(ctx, out, &md_len) && md_len == 32;
+}
 
-  unsigned char md_value[EVP_MAX_MD_SIZE];
+// Continues from a saved state: copy it into the thread's context, absorb
+// data, finalize.
+bool resume_digest(const EVP_MD_CTX *state, const void *data, std::size_t size,
+                   unsigned char *out) {
+  EVP_MD_CTX *ctx = thread_context();
   unsigned int md_len = 0;
+  return ctx && 1 == EVP_MD_CTX_copy_ex(ctx, state) &&
+         1 == EVP_DigestUpdate(ctx, data, size) &&
+         1 == EVP_DigestFinal_ex(ctx, out, &md_len) && md_len == 32;
+}
 
-  if (1 != EVP_DigestInit_ex(mdctx, md, nullptr)) {
-    EVP_MD_CTX_free(mdctx);
-    return {};
+} // namespace
+
+struct SHA256_Hasher::HmacKey {
+  Context inner;
+  Context outer;
+};
+
+SHA256_Hasher::SHA256_Hasher(std::string_view key) {
+  unsigned char block[kBlockSize] = {};
+  if (key.size() > kBlockSize) {
+    if (!plain_digest(key, block)) {
+      throw std::runtime_error("SHA-256 HMAC key hashing failed");
+    }
+  } else {
+    std::copy(key.begin(), key.end(), block);
   }
-  if (1 != EVP_DigestUpdate(mdctx, input.data(), input.size())) {
-    EVP_MD_CTX_free(mdctx);
-    return {};
+
+  auto padded_state = [&block](unsigned char pad) {
+    unsigned char padded[kBlockSize];
+    for (std::size_t i = 0; i < kBlockSize; ++i) {
+      padded[i] = static_cast<unsigned char>(block[i] ^ pad);
+    }
+    Context ctx(EVP_MD_CTX_new());
+    if (!ctx || !sha256_md() ||
+        1 != EVP_DigestInit_ex(ctx.get(), sha256_md(), nullptr) ||
+        1 != EVP_DigestUpdate(ctx.get(), padded, sizeof(padded))) {
+      throw std::runtime_error("SHA-256 HMAC key schedule failed");
+    }
+    return ctx;
+  };
+  auto key_state = std::make_shared<HmacKey>();
+  key_state->inner = padded_state(0x36);
+  key_state->outer = padded_state(0x5c);
+  hmac = std::move(key_state);
+}
+
+std::unique_ptr<IHasher> SHA256_Hasher::keyed(std::string_view key) const {
+  return std::make_unique<SHA256_Hasher>(key);
+}
+
+bool SHA256_Hasher::digest_into(std::string_view input,
+                                unsigned char *out) const {
+  if (!hmac) {
+    return plain_digest(input, out);
   }
-  if (1 != EVP_DigestFinal_ex(mdctx, md_value, &md_len)) {
-    EVP_MD_CTX_free(mdctx);
+  unsigned char inner[32];
+  return resume_digest(hmac->inner.get(), input.data(), input.size(), inner) &&
+         resume_digest(hmac->outer.get(), inner, sizeof(inner), out);
+}
+
+std::string SHA256_Hasher::hash256bit(const std::string &input) const {
+  unsigned char md_value[32];
+  if (!digest_into(input, md_value)) {
     return {};
   }
+  return hex_encode(md_value);
+}
 
-  EVP_MD_CTX_free(mdctx);
-
-  static const char hex_chars[] = "0123456789abcdef";
-  std::string output;
-  output.reserve(md_len * 2);
-  for (unsigned int i = 0; i < md_len; ++i) {
-    unsigned char b = md_value[i];
-    output.push_back(hex_chars[(b >> 4) & 0x0F]);
-    output.push_back(hex_chars[b & 0x0F]);
+std::vector<std::string>
+SHA256_Hasher::hash256bit_batch(std::span<const std::string> inputs) const {
+  std::vector<std::string> digests;
+  digests.reserve(inputs.size());
+  unsigned char md_value[32];
+  for (const auto &input : inputs) {
+    digests.push_back(digest_into(input, md_value)
+                          ? hex_encode(md_value)
+                          : std::string{});
   }
+  return digests;
+}
 
-  return output;
+SHA256_Hasher::Digest SHA256_Hasher::digest(std::string_view input) const {
+  Digest out;
+  if (!digest_into(input, out.data())) {
+    throw std::runtime_error("SHA-256 digest failed: " +
+                             std::to_string(ERR_get_error()));
+  }
+  return out;
 }
\ No newline at end of file
@@ -1 +1,31 @@
+#include <crypto/AIHasher.h>
+#include <crypto/transaction.h>
+#include <string>
+#include <utility>
 
+const AIHasher &txid_hasher() {
+  static const AIHasher hasher;
+  return hasher;
+}
+
+std::string transaction_payload(const Transaction &transaction) {
+  std::string payload;
+  payload.reserve(transaction.sender.size() + transaction.receiver.size() + 22U);
+  payload.append(transaction.sender);
+  payload.push_back('\x1f');
+  payload.append(transaction.receiver);
+  payload.push_back('\x1f');
+  payload.append(std::to_string(transaction.amount));
+  return payload;
+}
+
+std::string compute_txid(const Transaction &transaction) {
+  return txid_hasher().hash256bit(transaction_payload(transaction));
+}
+
+Transaction make_transaction(std::string sender, std::string receiver,
+                             uint64_t amount) {
+  Transaction transaction{{}, std::move(sender), std::move(receiver), amount};
+  transaction.txid = compute_txid(transaction);
+  return transaction;
+}
\ No newline at end of file
@@ -0,0 +1,115 @@
+#include <Timer.h>
+#include <thread_pool.h>
+#include <crypto/transaction_verifier.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t kMinTransactionsPerWorker = 1024;
+constexpr std::size_t kTxidShards = 64;
+constexpr std::size_t kNoInvalid = std::numeric_limits<std::size_t>::max();
+
+class ConcurrentTxidSet {
+  struct Shard {
+    std::mutex mutex;
+    std::unordered_set<std::string_view> txids;
+  };
+  std::array<Shard, kTxidShards> shards;
+
+public:
+  explicit ConcurrentTxidSet(std::size_t expected) {
+    for (auto &shard : shards) {
+      shard.txids.reserve(expected / kTxidShards + 1U);
+    }
+  }
+
+  bool insert(std::string_view txid) {
+    Shard &shard = shards[(std::hash<std::string_view>{}(txid) >> 7U) % kTxidShards];
+    std::lock_guard lock(shard.mutex);
+    return shard.txids.insert(txid).second;
+  }
+};
+
+void record_min(std::atomic<std::size_t> &slot, std::size_t index) {
+  std::size_t current = slot.load(std::memory_order_relaxed);
+  while (index < current &&
+         !slot.compare_exchange_weak(current, index, std::memory_order_relaxed)) {
+  }
+}
+
+} // namespace
+
+VerificationResult
+TransactionVerifier::verify(std::span<const Transaction> transactions,
+                            BalanceIndex &balances) const {
+  VerificationResult result;
+  auto reject = [&result](std::size_t index, const char *reason) {
+    result.valid = false;
+    result.first_invalid_index = index;
+    result.reason = reason;
+    return result;
+  };
+
+  ThreadPool &pool = ThreadPool::global();
+  Timer timer;
+  std::atomic<std::size_t> bad_txid{kNoInvalid};
+  pool.parallel_for(
+      transactions.size(), kMinTransactionsPerWorker,
+      [&](std::size_t begin, std::size_t end) {
+        std::vector<std::string> payloads;
+        payloads.reserve(end - begin);
+        for (std::size_t i = begin; i < end; ++i) {
+          payloads.push_back(transaction_payload(transactions[i]));
+        }
+        const auto digests = txid_hasher().hash256bit_batch(payloads);
+        for (std::size_t i = begin; i < end; ++i) {
+          if (digests[i - begin] != transactions[i].txid) {
+            record_min(bad_txid, i);
+            return;
+          }
+        }
+      },
+      thread_count);
+  result.timings.txid_seconds = timer.elapsed();
+  if (bad_txid.load() != kNoInvalid) {
+    return reject(bad_txid.load(), "txid does not match transaction contents");
+  }
+
+  timer.reset();
+  std::atomic<std::size_t> duplicate{kNoInvalid};
+  ConcurrentTxidSet txids(transactions.size());
+  pool.parallel_for(
+      transactions.size(), kMinTransactionsPerWorker,
+      [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+          if (!txids.insert(transactions[i].txid)) {
+            record_min(duplicate, i);
+          }
+        }
+      },
+      thread_count);
+  result.timings.conflict_seconds = timer.elapsed();
+  if (duplicate.load() != kNoInvalid) {
+    return reject(duplicate.load(), "duplicate txid within block");
+  }
+
+  timer.reset();
+  std::size_t failed = 0;
+  BalanceError error = BalanceError::overdraft;
+  const bool applied = balances.apply_block(transactions, &failed, &error);
+  result.timings.balance_seconds = timer.elapsed();
+  if (!applied) {
+    return reject(failed, error == BalanceError::overflow ? "receiver balance overflows"
+                                                         : "sender balance too low");
+  }
+  return result;
+}
\ No newline at end of file
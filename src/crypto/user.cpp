@@ -0,0 +1,107 @@
+#include <crypto/user.h>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+UserId UserTable::intern(std::string_view name) {
+  if (const auto it = ids.find(name); it != ids.end()) {
+    return it->second;
+  }
+  const auto id = static_cast<UserId>(names.emplace_back(name));
+  try {
+    ids.emplace(names[id], id);
+  } catch (...) {
+    names.pop_back();
+    throw;
+  }
+  return id;
+}
+
+std::optional<UserId> UserTable::find(std::string_view name) const {
+  const auto it = ids.find(name);
+  if (it == ids.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+const std::string &UserTable::name(UserId id) const {
+  if (id >= names.size()) {
+    std::ostringstream msg;
+    msg << "unknown user id " << id;
+    throw std::out_of_range(msg.str());
+  }
+  return names[id];
+}
+
+bool BalanceIndex::apply_block(std::span<const Transaction> transactions,
+                               std::size_t *failed_index, BalanceError *error) {
+  BlockUndo undo;
+  auto fail = [&](std::size_t index, BalanceError cause) {
+    restore(undo);
+    if (failed_index != nullptr) {
+      *failed_index = index;
+    }
+    if (error != nullptr) {
+      *error = cause;
+    }
+    return false;
+  };
+  for (std::size_t i = 0; i < transactions.size(); ++i) {
+    const Transaction &tx = transactions[i];
+    const UserId receiver = touch(tx.receiver, undo);
+    if (!tx.sender.empty()) {
+      const UserId sender = touch(tx.sender, undo);
+      if (balances[sender] < tx.amount) {
+        return fail(i, BalanceError::overdraft);
+      }
+      balances[sender] -= tx.amount;
+    }
+    // Debited first, so paying oneself cannot trip this.
+    if (balances[receiver] > std::numeric_limits<std::uint64_t>::max() - tx.amount) {
+      return fail(i, BalanceError::overflow);
+    }
+    balances[receiver] += tx.amount;
+  }
+  undo_log.push_back(std::move(undo));
+  return true;
+}
+
+void BalanceIndex::rollback_block() {
+  if (undo_log.empty()) {
+    throw std::logic_error("no block to roll back");
+  }
+  restore(undo_log.back());
+  undo_log.pop_back();
+}
+
+std::uint64_t BalanceIndex::balance(UserId id) const {
+  return id < balances.size() ? balances[id] : 0;
+}
+
+std::uint64_t BalanceIndex::balance(std::string_view user) const {
+  const auto id = user_table.find(user);
+  return id ? balance(*id) : 0;
+}
+
+UserId BalanceIndex::touch(std::string_view user, BlockUndo &undo) {
+  const UserId id = user_table.intern(user);
+  if (id >= balances.size()) {
+    balances.resize(id + 1U, 0);
+    recorded_in.resize(id + 1U, 0);
+  }
+  const std::size_t slot = undo_log.size() + 1U;
+  if (recorded_in[id] != slot) {
+    undo.previous_balances.emplace_back(id, balances[id]);
+    recorded_in[id] = slot;
+  }
+  return id;
+}
+
+void BalanceIndex::restore(const BlockUndo &undo) {
+  for (auto it = undo.previous_balances.rbegin();
+       it != undo.previous_balances.rend(); ++it) {
+    balances[it->first] = it->second;
+    recorded_in[it->first] = 0;
+  }
+}
\ No newline at end of file
@@ -0,0 +1,250 @@
+#include <hex.h>
+#include <array>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define HASHF_HEX_X86 1
+#include <immintrin.h>
+#else
+#define HASHF_HEX_X86 0
+#endif
+
+namespace {
+
+constexpr char kDigits[] = "0123456789abcdef";
+
+constexpr std::array<std::array<char, 2>, 256> kEncodeTable = [] {
+  std::array<std::array<char, 2>, 256> table{};
+  for (std::size_t byte = 0; byte < 256; ++byte) {
+    table[byte] = {kDigits[byte >> 4U], kDigits[byte & 0x0FU]};
+  }
+  return table;
+}();
+
+constexpr std::array<std::int8_t, 256> kDecodeTable = [] {
+  std::array<std::int8_t, 256> table{};
+  table.fill(-1);
+  for (std::int8_t v = 0; v < 16; ++v) {
+    table[static_cast<unsigned char>(kDigits[v])] = v;
+    if (v >= 10) {
+      table[static_cast<unsigned char>(kDigits[v] - 'a' + 'A')] = v;
+    }
+  }
+  return table;
+}();
+
+void encode_scalar(const std::uint8_t *in, std::size_t size, char *out) {
+  for (std::size_t i = 0; i < size; ++i) {
+    std::memcpy(out + 2 * i, kEncodeTable[in[i]].data(), 2);
+  }
+}
+
+std::size_t decode_scalar(const char *in, std::size_t size, std::uint8_t *out) {
+  for (std::size_t i = 0; i < size; ++i) {
+    const int hi = kDecodeTable[static_cast<unsigned char>(in[2 * i])];
+    const int lo = kDecodeTable[static_cast<unsigned char>(in[2 * i + 1])];
+    if ((hi | lo) < 0) {
+      return hi < 0 ? 2 * i : 2 * i + 1;
+    }
+    out[i] = static_cast<std::uint8_t>((hi << 4U) | lo);
+  }
+  return kHexValid;
+}
+
+// A SIMD block failed validation: rerun it in scalar to locate the offset.
+std::size_t rescan(const char *in, std::size_t at, std::size_t bytes,
+                   std::uint8_t *out) {
+  return at * 2 + decode_scalar(in + at * 2, bytes, out + at);
+}
+
+#if HASHF_HEX_X86
+
+// Per-character digit values; lanes that are not hex digits are set in bad.
+// Letters are folded to lowercase with | 0x20, which leaves '0'..'9' intact.
+[[gnu::target("ssse3")]] __m128i nibbles_ssse3(__m128i c, __m128i &bad) {
+  const __m128i digit = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+  const __m128i alpha =
+      _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+  const __m128i is_digit =
+      _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+  const __m128i is_alpha =
+      _mm_cmpeq_epi8(_mm_min_epu8(alpha, _mm_set1_epi8(5)), alpha);
+  const __m128i valid = _mm_or_si128(is_digit, is_alpha);
+  bad = _mm_or_si128(bad, _mm_cmpeq_epi8(valid, _mm_setzero_si128()));
+  return _mm_or_si128(_mm_and_si128(is_digit, digit),
+                      _mm_and_si128(is_alpha, _mm_add_epi8(alpha, _mm_set1_epi8(10))));
+}
+
+[[gnu::target("ssse3")]] void encode_ssse3(const std::uint8_t *in,
+                                           std::size_t size, char *out) {
+  const __m128i lut = _mm_loadu_si128(reinterpret_cast<const __m128i *>(kDigits));
+  const __m128i mask = _mm_set1_epi8(0x0F);
+  std::size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+    const __m128i hi = _mm_shuffle_epi8(lut, _mm_and_si128(_mm_srli_epi16(v, 4), mask));
+    const __m128i lo = _mm_shuffle_epi8(lut, _mm_and_si128(v, mask));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * i), _mm_unpacklo_epi8(hi, lo));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * i + 16),
+                     _mm_unpackhi_epi8(hi, lo));
+  }
+  encode_scalar(in + i, size - i, out + 2 * i);
+}
+
+[[gnu::target("ssse3")]] std::size_t decode_ssse3(const char *in, std::size_t size,
+                                                  std::uint8_t *out) {
+  // maddubs with (16, 1) byte weights joins each digit pair into hi * 16 + lo.
+  const __m128i weights = _mm_set1_epi16(0x0110);
+  std::size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    __m128i bad = _mm_setzero_si128();
+    const __m128i a = nibbles_ssse3(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 2 * i)), bad);
+    const __m128i b = nibbles_ssse3(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 2 * i + 16)), bad);
+    if (_mm_movemask_epi8(bad) != 0) {
+      return rescan(in, i, 16, out);
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i),
+                     _mm_packus_epi16(_mm_maddubs_epi16(a, weights),
+                                      _mm_maddubs_epi16(b, weights)));
+  }
+  const std::size_t tail = decode_scalar(in + 2 * i, size - i, out + i);
+  return tail == kHexValid ? kHexValid : 2 * i + tail;
+}
+
+[[gnu::target("avx2")]] __m256i nibbles_avx2(__m256i c, __m256i &bad) {
+  const __m256i digit = _mm256_sub_epi8(c, _mm256_set1_epi8('0'));
+  const __m256i alpha = _mm256_sub_epi8(
+      _mm256_or_si256(c, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+  const __m256i is_digit =
+      _mm256_cmpeq_epi8(_mm256_min_epu8(digit, _mm256_set1_epi8(9)), digit);
+  const __m256i is_alpha =
+      _mm256_cmpeq_epi8(_mm256_min_epu8(alpha, _mm256_set1_epi8(5)), alpha);
+  const __m256i valid = _mm256_or_si256(is_digit, is_alpha);
+  bad = _mm256_or_si256(bad, _mm256_cmpeq_epi8(valid, _mm256_setzero_si256()));
+  return _mm256_or_si256(
+      _mm256_and_si256(is_digit, digit),
+      _mm256_and_si256(is_alpha, _mm256_add_epi8(alpha, _mm256_set1_epi8(10))));
+}
+
+[[gnu::target("avx2")]] void encode_avx2(const std::uint8_t *in, std::size_t size,
+                                         char *out) {
+  const __m256i lut = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(kDigits)));
+  const __m256i mask = _mm256_set1_epi8(0x0F);
+  std::size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+    const __m256i hi =
+        _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), mask));
+    const __m256i lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(v, mask));
+    // Unpacks work within 128-bit lanes; swap the middle halves back.
+    const __m256i first = _mm256_unpacklo_epi8(hi, lo);
+    const __m256i second = _mm256_unpackhi_epi8(hi, lo);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 2 * i),
+                        _mm256_permute2x128_si256(first, second, 0x20));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 2 * i + 32),
+                        _mm256_permute2x128_si256(first, second, 0x31));
+  }
+  encode_ssse3(in + i, size - i, out + 2 * i);
+}
+
+[[gnu::target("avx2")]] std::size_t decode_avx2(const char *in, std::size_t size,
+                                                std::uint8_t *out) {
+  const __m256i weights = _mm256_set1_epi16(0x0110);
+  std::size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    __m256i bad = _mm256_setzero_si256();
+    const __m256i a = nibbles_avx2(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + 2 * i)), bad);
+    const __m256i b = nibbles_avx2(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + 2 * i + 32)), bad);
+    if (_mm256_movemask_epi8(bad) != 0) {
+      return rescan(in, i, 32, out);
+    }
+    const __m256i packed = _mm256_packus_epi16(_mm256_maddubs_epi16(a, weights),
+                                               _mm256_maddubs_epi16(b, weights));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i),
+                        _mm256_permute4x64_epi64(packed, 0xD8));
+  }
+  const std::size_t tail = decode_ssse3(in + 2 * i, size - i, out + i);
+  return tail == kHexValid ? kHexValid : 2 * i + tail;
+}
+
+#endif
+
+struct CodecTable {
+  std::array<HexCodec, 3> codecs;
+  std::size_t count = 0;
+};
+
+CodecTable detect_codecs() {
+  CodecTable table;
+  table.codecs[table.count++] = {"scalar", encode_scalar, decode_scalar};
+#if HASHF_HEX_X86
+  if (__builtin_cpu_supports("ssse3")) {
+    table.codecs[table.count++] = {"ssse3", encode_ssse3, decode_ssse3};
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    table.codecs[table.count++] = {"avx2", encode_avx2, decode_avx2};
+  }
+#endif
+  return table;
+}
+
+const HexCodec &active_codec() {
+  static const HexCodec codec = hex_codecs().back();
+  return codec;
+}
+
+} // namespace
+
+std::span<const HexCodec> hex_codecs() {
+  static const CodecTable table = detect_codecs();
+  return {table.codecs.data(), table.count};
+}
+
+void hex_encode(std::span<const std::uint8_t> bytes, char *out) {
+  active_codec().encode(bytes.data(), bytes.size(), out);
+}
+
+std::string hex_encode(std::span<const std::uint8_t> bytes) {
+  std::string out(bytes.size() * 2, '\0');
+  hex_encode(bytes, out.data());
+  return out;
+}
+
+bool hex_decode(std::string_view hex, std::uint8_t *out,
+                std::size_t *error_offset) {
+  std::size_t bad = hex.size();
+  if (hex.size() % 2 == 0) {
+    bad = active_codec().decode(hex.data(), hex.size() / 2, out);
+    if (bad == kHexValid) {
+      return true;
+    }
+  }
+  if (error_offset) {
+    *error_offset = bad;
+  }
+  return false;
+}
+
+std::vector<std::uint8_t> hex_decode(std::string_view hex) {
+  std::vector<std::uint8_t> out(hex.size() / 2);
+  std::size_t bad = 0;
+  if (!hex_decode(hex, out.data(), &bad)) {
+    std::ostringstream msg;
+    if (bad == hex.size()) {
+      msg << "hex string has odd length " << hex.size();
+    } else {
+      msg << "invalid hex character '" << hex[bad] << "' at offset " << bad;
+    }
+    throw std::invalid_argument(msg.str());
+  }
+  return out;
+}
+
+int hex_value(char c) { return kDecodeTable[static_cast<unsigned char>(c)]; }
\ No newline at end of file
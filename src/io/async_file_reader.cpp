@@ -0,0 +1,433 @@
+#include <async_file_reader.h>
+#include <FileRead.h>
+#include <thread_pool.h>
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <system_error>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define HASHF_HAS_PREAD 1
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define HASHF_HAS_PREAD 0
+#endif
+
+#if HASHF_HAS_IO_URING
+#include <atomic>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+namespace {
+
+#if HASHF_HAS_PREAD
+
+[[noreturn]] void throw_file_error(const char *what,
+                                   const std::filesystem::path &path, int error) {
+  throw std::filesystem::filesystem_error(
+      what, path, std::error_code(error, std::generic_category()));
+}
+
+int open_for_read(const std::filesystem::path &path, std::size_t &size) {
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throw_file_error("cannot open file", path, errno);
+  }
+  struct stat info {};
+  if (::fstat(fd, &info) != 0) {
+    const int error = errno;
+    ::close(fd);
+    throw_file_error("cannot stat file", path, error);
+  }
+  size = static_cast<std::size_t>(info.st_size);
+  return fd;
+}
+
+void pread_whole(const std::filesystem::path &path, std::string &data) {
+  std::size_t size = 0;
+  const int fd = open_for_read(path, size);
+  data.resize(size);
+  std::size_t done = 0;
+  while (done < size) {
+    const ssize_t n = ::pread(fd, data.data() + done, size - done,
+                              static_cast<off_t>(done));
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      const int error = errno;
+      ::close(fd);
+      throw_file_error("cannot read file", path, error);
+    }
+    if (n == 0) {
+      break;
+    }
+    done += static_cast<std::size_t>(n);
+  }
+  ::close(fd);
+  data.resize(done);
+}
+
+#else
+
+void pread_whole(const std::filesystem::path &path, std::string &data) {
+  data = ReadFile(path);
+}
+
+#endif
+
+} // namespace
+
+#if HASHF_HAS_IO_URING
+
+// The few parts of an io_uring this reader needs, on raw syscalls: one
+// submitter thread, one completion consumer (the same thread).
+struct AsyncFileReader::Ring {
+  explicit Ring(unsigned depth) {
+    io_uring_params params{};
+    fd = static_cast<int>(::syscall(__NR_io_uring_setup, depth, &params));
+    if (fd < 0) {
+      throw std::system_error(errno, std::generic_category(), "io_uring_setup");
+    }
+    sq_map_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_map_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single_map = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_map) {
+      sq_map_size = cq_map_size = std::max(sq_map_size, cq_map_size);
+    }
+    sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+
+    sq_map = map(sq_map_size, IORING_OFF_SQ_RING);
+    cq_map = single_map ? sq_map : map(cq_map_size, IORING_OFF_CQ_RING);
+    void *sqe_map = map(sqes_size, IORING_OFF_SQES);
+    if (sq_map == MAP_FAILED || cq_map == MAP_FAILED || sqe_map == MAP_FAILED) {
+      const int error = errno;
+      sqes = static_cast<io_uring_sqe *>(sqe_map);
+      release();
+      throw std::system_error(error, std::generic_category(), "io_uring mmap");
+    }
+    sqes = static_cast<io_uring_sqe *>(sqe_map);
+
+    auto *sq = static_cast<char *>(sq_map);
+    sq_head = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sq_mask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    auto *cq = static_cast<char *>(cq_map);
+    cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cq_mask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+  }
+
+  Ring(const Ring &) = delete;
+  Ring &operator=(const Ring &) = delete;
+  ~Ring() { release(); }
+
+  // Registered buffers let the kernel skip pinning pages on every read.
+  // Fails harmlessly under a tight RLIMIT_MEMLOCK; plain reads still work.
+  bool register_buffers(char *base, std::size_t size, unsigned count) {
+    std::vector<iovec> iovecs(count);
+    for (unsigned i = 0; i < count; ++i) {
+      iovecs[i] = {base + i * size, size};
+    }
+    fixed_buffers = ::syscall(__NR_io_uring_register, fd, IORING_REGISTER_BUFFERS,
+                              iovecs.data(), count) == 0;
+    return fixed_buffers;
+  }
+
+  // The caller never has more operations outstanding than the ring has
+  // entries, so a slot is always free.
+  io_uring_sqe &next_sqe() {
+    const unsigned tail = *sq_tail;
+    const unsigned index = tail & sq_mask;
+    sq_array[index] = index;
+    io_uring_sqe &sqe = sqes[index];
+    std::memset(&sqe, 0, sizeof(sqe));
+    std::atomic_ref<unsigned>(*sq_tail).store(tail + 1, std::memory_order_release);
+    ++to_submit;
+    return sqe;
+  }
+
+  void submit_and_wait(unsigned wait_for) {
+    while (true) {
+      const long submitted =
+          ::syscall(__NR_io_uring_enter, fd, to_submit, wait_for,
+                    wait_for > 0 ? IORING_ENTER_GETEVENTS : 0U, nullptr, 0);
+      if (submitted >= 0) {
+        to_submit -= static_cast<unsigned>(submitted);
+        return;
+      }
+      if (errno != EINTR) {
+        throw std::system_error(errno, std::generic_category(), "io_uring_enter");
+      }
+    }
+  }
+
+  template <typename Fn> void drain(Fn &&fn) {
+    unsigned head = *cq_head;
+    const unsigned tail =
+        std::atomic_ref<unsigned>(*cq_tail).load(std::memory_order_acquire);
+    for (; head != tail; ++head) {
+      const io_uring_cqe &cqe = cqes[head & cq_mask];
+      fn(cqe.user_data, cqe.res);
+    }
+    std::atomic_ref<unsigned>(*cq_head).store(head, std::memory_order_release);
+  }
+
+  bool fixed_buffers = false;
+
+private:
+  void *map(std::size_t size, off_t offset) const {
+    return ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                  fd, offset);
+  }
+
+  void release() {
+    if (sqes != MAP_FAILED) {
+      ::munmap(sqes, sqes_size);
+    }
+    if (cq_map != MAP_FAILED && cq_map != sq_map) {
+      ::munmap(cq_map, cq_map_size);
+    }
+    if (sq_map != MAP_FAILED) {
+      ::munmap(sq_map, sq_map_size);
+    }
+    ::close(fd);
+  }
+
+  int fd = -1;
+  void *sq_map = MAP_FAILED;
+  void *cq_map = MAP_FAILED;
+  io_uring_sqe *sqes = static_cast<io_uring_sqe *>(MAP_FAILED);
+  std::size_t sq_map_size = 0;
+  std::size_t cq_map_size = 0;
+  std::size_t sqes_size = 0;
+  unsigned *sq_head = nullptr;
+  unsigned *sq_tail = nullptr;
+  unsigned *sq_array = nullptr;
+  unsigned sq_mask = 0;
+  unsigned *cq_head = nullptr;
+  unsigned *cq_tail = nullptr;
+  unsigned cq_mask = 0;
+  io_uring_cqe *cqes = nullptr;
+  unsigned to_submit = 0;
+};
+
+#else
+
+struct AsyncFileReader::Ring {};
+
+#endif
+
+AsyncFileReader::AsyncFileReader(AsyncReadOptions read_options)
+    : options(read_options) {
+  options.queue_depth = std::max(1U, options.queue_depth);
+  options.buffer_size = std::max<std::size_t>(4096, options.buffer_size);
+#if HASHF_HAS_IO_URING
+  if (!options.force_pread) {
+    try {
+      ring = std::make_unique<Ring>(std::bit_ceil(options.queue_depth));
+      buffers.resize(options.buffer_size * options.queue_depth);
+      ring->register_buffers(buffers.data(), options.buffer_size, options.queue_depth);
+    } catch (const std::system_error &) {
+      ring.reset();
+      buffers.clear();
+    }
+  }
+#endif
+}
+
+AsyncFileReader::~AsyncFileReader() = default;
+
+const char *AsyncFileReader::backend() const {
+  return ring ? "io_uring" : "pread";
+}
+
+void AsyncFileReader::read_all(std::span<const std::filesystem::path> files,
+                               const Consumer &consume) {
+  if (ring) {
+    read_all_ring(files, consume);
+  } else {
+    read_all_pread(files, consume);
+  }
+}
+
+void AsyncFileReader::read_all_pread(std::span<const std::filesystem::path> files,
+                                     const Consumer &consume) {
+  ThreadPool::global().parallel_for(
+      files.size(), 1,
+      [&](std::size_t begin, std::size_t end) {
+        std::string data;
+        for (std::size_t i = begin; i < end; ++i) {
+          pread_whole(files[i], data);
+          consume(i, data);
+        }
+      },
+      options.queue_depth);
+}
+
+#if HASHF_HAS_IO_URING
+
+// Slot i pairs an in-flight read with buffer i. A slot is taken when its
+// file is opened and given back when the consumer returns, so queue_depth
+// bounds both the reads in flight and the buffers held by consumers.
+void AsyncFileReader::read_all_ring(std::span<const std::filesystem::path> files,
+                                    const Consumer &consume) {
+  struct Job {
+    std::size_t file = 0;
+    int fd = -1;
+    std::size_t size = 0;
+    std::size_t done = 0;
+    char *target = nullptr;
+    std::string large;
+  };
+  constexpr std::size_t kMaxReadSize = std::size_t{1} << 30U;
+  const unsigned depth = options.queue_depth;
+
+  std::vector<Job> jobs(depth);
+  std::mutex mutex;
+  std::condition_variable released;
+  std::vector<unsigned> free_slots(depth);
+  for (unsigned i = 0; i < depth; ++i) {
+    free_slots[i] = depth - 1 - i;
+  }
+  std::exception_ptr failure;
+  unsigned in_flight = 0;
+  TaskGroup group;
+
+  auto release_slot = [&](unsigned slot) {
+    {
+      std::lock_guard lock(mutex);
+      free_slots.push_back(slot);
+    }
+    released.notify_one();
+  };
+  auto fail = [&](unsigned slot, std::exception_ptr error) {
+    ::close(jobs[slot].fd);
+    if (!failure) {
+      failure = std::move(error);
+    }
+    release_slot(slot);
+  };
+  auto queue_read = [&](unsigned slot) {
+    Job &job = jobs[slot];
+    const bool pooled = job.large.empty();
+    io_uring_sqe &sqe = ring->next_sqe();
+    sqe.opcode = pooled && ring->fixed_buffers ? IORING_OP_READ_FIXED : IORING_OP_READ;
+    sqe.fd = job.fd;
+    sqe.addr = reinterpret_cast<std::uint64_t>(job.target + job.done);
+    sqe.len = static_cast<std::uint32_t>(std::min(job.size - job.done, kMaxReadSize));
+    sqe.off = job.done;
+    sqe.buf_index = pooled ? static_cast<std::uint16_t>(slot) : 0;
+    sqe.user_data = slot;
+    ++in_flight;
+  };
+  auto complete = [&](unsigned slot) {
+    Job &job = jobs[slot];
+    ::close(job.fd);
+    const std::string_view data(job.target, job.done);
+    group.run([&consume, &release_slot, slot, file = job.file, data]() {
+      try {
+        consume(file, data);
+      } catch (...) {
+        release_slot(slot);
+        throw;
+      }
+      release_slot(slot);
+    });
+  };
+  auto start = [&](unsigned slot, std::size_t file) {
+    Job &job = jobs[slot];
+    job = Job{};
+    job.file = file;
+    try {
+      job.fd = open_for_read(files[file], job.size);
+    } catch (...) {
+      if (!failure) {
+        failure = std::current_exception();
+      }
+      release_slot(slot);
+      return;
+    }
+    if (job.size > options.buffer_size) {
+      job.large.resize(job.size);
+      job.target = job.large.data();
+    } else {
+      job.target = buffers.data() + slot * options.buffer_size;
+    }
+    if (job.size == 0) {
+      complete(slot);
+    } else {
+      queue_read(slot);
+    }
+  };
+
+  std::size_t next = 0;
+  while (true) {
+    while (!failure && next < files.size()) {
+      std::unique_lock lock(mutex);
+      if (free_slots.empty()) {
+        break;
+      }
+      const unsigned slot = free_slots.back();
+      free_slots.pop_back();
+      lock.unlock();
+      start(slot, next++);
+    }
+    if (in_flight == 0) {
+      if (failure || next == files.size()) {
+        break;
+      }
+      // Every slot is with a consumer: help run one, or wait for a slot.
+      if (!ThreadPool::global().try_run_one()) {
+        std::unique_lock lock(mutex);
+        released.wait_for(lock, std::chrono::microseconds(200),
+                          [&]() { return !free_slots.empty(); });
+      }
+      continue;
+    }
+
+    ring->submit_and_wait(1);
+    ring->drain([&](std::uint64_t user_data, int result) {
+      const auto slot = static_cast<unsigned>(user_data);
+      Job &job = jobs[slot];
+      --in_flight;
+      if (result < 0) {
+        fail(slot, std::make_exception_ptr(std::filesystem::filesystem_error(
+                       "cannot read file", files[job.file],
+                       std::error_code(-result, std::generic_category()))));
+      } else if (result == 0 || (job.done += static_cast<std::size_t>(result)) == job.size) {
+        // A zero-length read means the file shrank; hand over what arrived.
+        complete(slot);
+      } else {
+        queue_read(slot);
+      }
+    });
+  }
+
+  group.wait();
+  if (failure) {
+    std::rethrow_exception(failure);
+  }
+}
+
+#else
+
+void AsyncFileReader::read_all_ring(std::span<const std::filesystem::path> files,
+                                    const Consumer &consume) {
+  read_all_pread(files, consume);
+}
+
+#endif
\ No newline at end of file
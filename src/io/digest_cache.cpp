@@ -0,0 +1,373 @@
+#include <crypto/AIHasher64.h>
+#include <digest_cache.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// On-disk layout: a 64-byte header followed by `capacity` 80-byte entries.
+struct Header {
+  std::array<char, 8> magic;
+  std::uint64_t capacity;
+  std::uint64_t count;
+  std::array<std::uint64_t, 5> reserved;
+};
+
+struct Entry {
+  std::uint64_t algorithm;
+  std::uint64_t device;
+  std::uint64_t inode;
+  std::uint64_t size;
+  std::int64_t mtime_ns;
+  DigestCache::Digest digest;
+  // Checksum of the fields above; 0 marks an empty slot.
+  std::uint64_t check;
+};
+
+static_assert(sizeof(Header) == 64);
+static_assert(sizeof(Entry) == 80);
+
+constexpr std::array<char, 8> kMagic = {'H', 'F', 'D', 'I', 'G', 'C', '1', '\0'};
+constexpr std::size_t kInitialCapacity = 1024;
+constexpr std::uint64_t kCheckSeed = 0x4446434B53554DULL;
+
+[[noreturn]] void throw_errno(const char *what) {
+  throw std::system_error(errno, std::generic_category(), what);
+}
+
+template <typename T> std::uint64_t hash_of(const T &value, std::size_t bytes) {
+  return AIHasher64::hash(
+      std::string_view(reinterpret_cast<const char *>(&value), bytes), kCheckSeed);
+}
+
+std::int64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+// Holds an exclusive flock for its scope.
+class FileLock {
+public:
+  explicit FileLock(int fd) : fd(fd) {
+    while (::flock(fd, LOCK_EX) != 0) {
+      if (errno != EINTR) {
+        throw_errno("flock");
+      }
+    }
+  }
+  FileLock(const FileLock &) = delete;
+  FileLock &operator=(const FileLock &) = delete;
+  ~FileLock() { ::flock(fd, LOCK_UN); }
+
+  int fd;
+};
+
+} // namespace
+
+FileIdentity file_identity(const std::filesystem::path &path) {
+  struct stat info {};
+  if (::stat(path.c_str(), &info) != 0) {
+    throw std::filesystem::filesystem_error(
+        "cannot stat file", path, std::error_code(errno, std::generic_category()));
+  }
+  return {static_cast<std::uint64_t>(info.st_dev),
+          static_cast<std::uint64_t>(info.st_ino),
+          static_cast<std::uint64_t>(info.st_size),
+          static_cast<std::int64_t>(info.st_mtim.tv_sec) * 1'000'000'000 +
+              info.st_mtim.tv_nsec};
+}
+
+namespace {
+
+std::uint64_t entry_check(const Entry &entry) {
+  return hash_of(entry, offsetof(Entry, check)) | 1U;
+}
+
+std::uint64_t slot_hash(const FileIdentity &identity, std::uint64_t algorithm) {
+  const std::array<std::uint64_t, 3> key = {identity.device, identity.inode, algorithm};
+  return hash_of(key, sizeof(key));
+}
+
+bool same_key(const Entry &entry, const FileIdentity &identity,
+              std::uint64_t algorithm) {
+  return entry.algorithm == algorithm && entry.device == identity.device &&
+         entry.inode == identity.inode;
+}
+
+Entry *entries_of(void *mapping) {
+  return reinterpret_cast<Entry *>(static_cast<char *>(mapping) + sizeof(Header));
+}
+
+std::size_t file_size_for(std::size_t capacity) {
+  return sizeof(Header) + capacity * sizeof(Entry);
+}
+
+// Creates an empty table of `capacity` slots in fd.
+void initialise(int fd, std::size_t capacity) {
+  if (::ftruncate(fd, static_cast<off_t>(file_size_for(capacity))) != 0) {
+    throw_errno("ftruncate");
+  }
+  Header header{kMagic, capacity, 0, {}};
+  if (::pwrite(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header))) {
+    throw_errno("pwrite");
+  }
+}
+
+void write_entry(Entry &slot, const Entry &value) {
+  // Readers see either the old entry, an empty slot or the new entry.
+  std::atomic_ref<std::uint64_t>(slot.check).store(0, std::memory_order_release);
+  std::memcpy(&slot, &value, offsetof(Entry, check));
+  std::atomic_ref<std::uint64_t>(slot.check).store(value.check,
+                                                   std::memory_order_release);
+}
+
+// Inserts or replaces under the writer lock; returns true for a new slot.
+bool insert(Entry *table, std::size_t capacity,
+            const Entry &value) {
+  const FileIdentity identity{value.device, value.inode, value.size, value.mtime_ns};
+  const std::size_t mask = capacity - 1;
+  for (std::size_t slot = slot_hash(identity, value.algorithm) & mask;;
+       slot = (slot + 1) & mask) {
+    Entry &entry = table[slot];
+    if (entry.check == 0) {
+      write_entry(entry, value);
+      return true;
+    }
+    // A checksum mismatch is a torn write from a crashed process; reuse it.
+    if (same_key(entry, identity, value.algorithm) || entry_check(entry) != entry.check) {
+      write_entry(entry, value);
+      return false;
+    }
+  }
+}
+
+} // namespace
+
+DigestCache::DigestCache(std::filesystem::path cache_path) : path(std::move(cache_path)) {
+  if (path.has_parent_path()) {
+    std::filesystem::create_directories(path.parent_path());
+  }
+  fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    throw_errno("open digest cache");
+  }
+  try {
+    {
+      FileLock lock(fd);
+      struct stat info {};
+      if (::fstat(fd, &info) != 0) {
+        throw_errno("fstat");
+      }
+      if (info.st_size == 0) {
+        initialise(fd, kInitialCapacity);
+      }
+    }
+    map_file();
+  } catch (...) {
+    unmap();
+    ::close(fd);
+    throw;
+  }
+}
+
+DigestCache::~DigestCache() {
+  unmap();
+  ::close(fd);
+}
+
+void DigestCache::map_file() {
+  struct stat info {};
+  if (::fstat(fd, &info) != 0) {
+    throw_errno("fstat");
+  }
+  mapped_size = static_cast<std::size_t>(info.st_size);
+  if (mapped_size < sizeof(Header)) {
+    throw std::runtime_error("'" + path.string() + "' is not a digest cache");
+  }
+  mapping = ::mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (mapping == MAP_FAILED) {
+    mapping = nullptr;
+    throw_errno("mmap digest cache");
+  }
+  const auto *header = static_cast<const Header *>(mapping);
+  if (header->magic != kMagic || !std::has_single_bit(header->capacity) ||
+      file_size_for(header->capacity) != mapped_size) {
+    throw std::runtime_error("'" + path.string() + "' is not a digest cache");
+  }
+}
+
+void DigestCache::unmap() {
+  if (mapping) {
+    ::munmap(mapping, mapped_size);
+    mapping = nullptr;
+  }
+}
+
+std::size_t DigestCache::size() const {
+  return static_cast<const Header *>(mapping)->count;
+}
+
+std::size_t DigestCache::capacity() const {
+  return static_cast<const Header *>(mapping)->capacity;
+}
+
+std::optional<DigestCache::Digest> DigestCache::find(const FileIdentity &identity,
+                                                     std::uint64_t algorithm) const {
+  const std::size_t mask = capacity() - 1;
+  for (std::size_t slot = slot_hash(identity, algorithm) & mask;;
+       slot = (slot + 1) & mask) {
+    Entry &shared = entries_of(mapping)[slot];
+    const std::uint64_t check =
+        std::atomic_ref<std::uint64_t>(shared.check).load(std::memory_order_acquire);
+    if (check == 0) {
+      break;
+    }
+    Entry entry;
+    std::memcpy(&entry, &shared, sizeof(entry));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (entry_check(entry) != check ||
+        std::atomic_ref<std::uint64_t>(shared.check).load(std::memory_order_relaxed) !=
+            check) {
+      continue;
+    }
+    if (same_key(entry, identity, algorithm)) {
+      if (entry.size != identity.size || entry.mtime_ns != identity.mtime_ns) {
+        break;
+      }
+      ++hit_count;
+      return entry.digest;
+    }
+  }
+  ++miss_count;
+  return std::nullopt;
+}
+
+// Called with the lock held: if another process grew the table, the path
+// now names a new file; switch to it and take its lock instead.
+void DigestCache::reopen_if_replaced() {
+  while (true) {
+    struct stat current {};
+    struct stat named {};
+    if (::fstat(fd, &current) != 0) {
+      throw_errno("fstat");
+    }
+    if (::stat(path.c_str(), &named) == 0 && named.st_ino == current.st_ino &&
+        named.st_dev == current.st_dev) {
+      return;
+    }
+    const int next = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+    if (next < 0) {
+      throw_errno("reopen digest cache");
+    }
+    unmap();
+    ::close(fd);
+    fd = next;
+    while (::flock(fd, LOCK_EX) != 0) {
+      if (errno != EINTR) {
+        throw_errno("flock");
+      }
+    }
+    map_file();
+  }
+}
+
+void DigestCache::grow(std::size_t min_entries) {
+  std::size_t new_capacity = capacity();
+  while (min_entries * 2 > new_capacity) {
+    new_capacity *= 2;
+  }
+  std::filesystem::path temporary = path;
+  temporary += ".tmp";
+  const int next = ::open(temporary.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (next < 0) {
+    throw_errno("create digest cache");
+  }
+  void *next_mapping = MAP_FAILED;
+  try {
+    if (::flock(next, LOCK_EX) != 0) {
+      throw_errno("flock");
+    }
+    initialise(next, new_capacity);
+    next_mapping = ::mmap(nullptr, file_size_for(new_capacity), PROT_READ | PROT_WRITE,
+                          MAP_SHARED, next, 0);
+    if (next_mapping == MAP_FAILED) {
+      throw_errno("mmap digest cache");
+    }
+    auto *next_header = static_cast<Header *>(next_mapping);
+    Entry *next_entries = entries_of(next_mapping);
+    for (std::size_t i = 0; i < capacity(); ++i) {
+      const Entry &entry = entries_of(mapping)[i];
+      if (entry.check != 0 && entry_check(entry) == entry.check &&
+          insert(next_entries, new_capacity, entry)) {
+        ++next_header->count;
+      }
+    }
+    if (::rename(temporary.c_str(), path.c_str()) != 0) {
+      throw_errno("rename digest cache");
+    }
+  } catch (...) {
+    if (next_mapping != MAP_FAILED) {
+      ::munmap(next_mapping, file_size_for(new_capacity));
+    }
+    ::close(next);
+    ::unlink(temporary.c_str());
+    throw;
+  }
+  // Closing the old descriptor releases its lock; waiting writers then see
+  // the rename in reopen_if_replaced().
+  unmap();
+  ::close(fd);
+  fd = next;
+  mapping = next_mapping;
+  mapped_size = file_size_for(new_capacity);
+}
+
+std::size_t DigestCache::store(std::span<const Record> records, std::uint64_t algorithm) {
+  const std::int64_t racy_after = now_ns() - kRacyWindowNs;
+  FileLock lock(fd);
+  reopen_if_replaced();
+  lock.fd = fd;
+
+  auto *header = static_cast<Header *>(mapping);
+  if ((header->count + records.size()) * 2 > header->capacity) {
+    grow(header->count + records.size());
+    lock.fd = fd;
+    header = static_cast<Header *>(mapping);
+  }
+
+  std::size_t stored = 0;
+  for (const Record &record : records) {
+    if (record.identity.mtime_ns >= racy_after) {
+      continue;
+    }
+    Entry entry{algorithm,
+                record.identity.device,
+                record.identity.inode,
+                record.identity.size,
+                record.identity.mtime_ns,
+                record.digest,
+                0};
+    entry.check = entry_check(entry);
+    if (insert(entries_of(mapping), header->capacity, entry)) {
+      ++header->count;
+    }
+    ++stored;
+  }
+  return stored;
+}
\ No newline at end of file
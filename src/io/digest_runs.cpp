@@ -0,0 +1,273 @@
+#include <digest_runs.h>
+#include <algorithm>
+#include <cerrno>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr std::size_t kRecordsPerTask = 4096;
+// Pages a run has been read past are dropped in steps of this many bytes,
+// so the merge does not grow the page cache share of the process.
+constexpr std::size_t kReleaseBytes = std::size_t{64} << 20U;
+
+[[noreturn]] void throw_errno(const std::string &what) {
+  throw std::system_error(errno, std::generic_category(), what);
+}
+
+void write_file(const std::filesystem::path &path, std::span<const DigestRecord> records) {
+  const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    throw_errno("open " + path.string());
+  }
+  const auto *data = reinterpret_cast<const char *>(records.data());
+  std::size_t left = records.size_bytes();
+  while (left > 0) {
+    const ssize_t written = ::write(fd, data, left);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      const int error = errno;
+      ::close(fd);
+      throw std::system_error(error, std::generic_category(), "write " + path.string());
+    }
+    data += written;
+    left -= static_cast<std::size_t>(written);
+  }
+  if (::close(fd) != 0) {
+    throw_errno("close " + path.string());
+  }
+}
+
+// A run file mapped read-only, consumed front to back.
+class MappedRun {
+public:
+  // The descriptor is closed before the constructor returns or throws; the
+  // mapping stays valid without it.
+  explicit MappedRun(const std::filesystem::path &path) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      throw_errno("open " + path.string());
+    }
+    auto fail = [&](const std::string &what) {
+      const int error = errno;
+      ::close(fd);
+      throw std::system_error(error, std::generic_category(), what + " " + path.string());
+    };
+    struct stat info {};
+    if (::fstat(fd, &info) != 0) {
+      fail("fstat");
+    }
+    size = static_cast<std::size_t>(info.st_size);
+    if (size % sizeof(DigestRecord) != 0) {
+      ::close(fd);
+      throw std::runtime_error("'" + path.string() + "' is not a digest run");
+    }
+    if (size == 0) {
+      ::close(fd);
+      return;
+    }
+    mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+      mapping = nullptr;
+      fail("mmap");
+    }
+    ::close(fd);
+    ::madvise(mapping, size, MADV_SEQUENTIAL);
+    cursor = static_cast<const DigestRecord *>(mapping);
+    end = cursor + size / sizeof(DigestRecord);
+  }
+  MappedRun(const MappedRun &) = delete;
+  MappedRun &operator=(const MappedRun &) = delete;
+  ~MappedRun() {
+    if (mapping) {
+      ::munmap(mapping, size);
+    }
+  }
+
+  [[nodiscard]] bool empty() const { return cursor == end; }
+  [[nodiscard]] const DigestRecord &front() const { return *cursor; }
+  [[nodiscard]] std::size_t bytes() const { return size; }
+
+  void pop() {
+    ++cursor;
+    const auto consumed = static_cast<std::size_t>(reinterpret_cast<const char *>(cursor) -
+                                                   static_cast<const char *>(mapping));
+    if (consumed - released >= kReleaseBytes) {
+      const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+      const std::size_t upto = consumed / page * page;
+      ::madvise(static_cast<char *>(mapping) + released, upto - released, MADV_DONTNEED);
+      released = upto;
+    }
+  }
+
+private:
+  void *mapping = nullptr;
+  std::size_t size = 0;
+  std::size_t released = 0;
+  const DigestRecord *cursor = nullptr;
+  const DigestRecord *end = nullptr;
+};
+
+} // namespace
+
+void radix_sort_records(std::span<const DigestRecord> records, std::span<DigestRecord> out,
+                        ThreadPool &pool) {
+  if (out.size() != records.size()) {
+    throw std::invalid_argument("radix_sort_records: output size differs");
+  }
+  const std::size_t n = records.size();
+  const std::size_t tasks = std::clamp<std::size_t>(n / kRecordsPerTask, 1,
+                                                    std::size_t{4} * std::max(1U, pool.size()));
+  const std::size_t chunk = (n + tasks - 1) / tasks;
+
+  // Per-task histograms of the first byte turn into per-task write
+  // positions, so the scatter needs no synchronisation and is stable.
+  std::vector<std::array<std::size_t, 256>> positions(tasks);
+  pool.parallel_for(
+      tasks, 1,
+      [&](std::size_t begin, std::size_t end) {
+        for (std::size_t t = begin; t < end; ++t) {
+          positions[t].fill(0);
+          for (std::size_t i = t * chunk; i < std::min(n, (t + 1) * chunk); ++i) {
+            ++positions[t][records[i].digest[0]];
+          }
+        }
+      },
+      tasks);
+  std::array<std::size_t, 257> bucket_start{};
+  std::size_t offset = 0;
+  for (std::size_t byte = 0; byte < 256; ++byte) {
+    bucket_start[byte] = offset;
+    for (std::size_t t = 0; t < tasks; ++t) {
+      const std::size_t count = positions[t][byte];
+      positions[t][byte] = offset;
+      offset += count;
+    }
+  }
+  bucket_start[256] = offset;
+  pool.parallel_for(
+      tasks, 1,
+      [&](std::size_t begin, std::size_t end) {
+        for (std::size_t t = begin; t < end; ++t) {
+          for (std::size_t i = t * chunk; i < std::min(n, (t + 1) * chunk); ++i) {
+            out[positions[t][records[i].digest[0]]++] = records[i];
+          }
+        }
+      },
+      tasks);
+  pool.parallel_for(256, 1, [&](std::size_t begin, std::size_t end) {
+    for (std::size_t byte = begin; byte < end; ++byte) {
+      std::sort(out.begin() + static_cast<std::ptrdiff_t>(bucket_start[byte]),
+                out.begin() + static_cast<std::ptrdiff_t>(bucket_start[byte + 1]));
+    }
+  });
+}
+
+DigestRunWriter::DigestRunWriter(std::filesystem::path dir, std::size_t run_records)
+    : dir(std::move(dir)), buffer(std::max<std::size_t>(run_records, 1)) {
+  std::filesystem::create_directories(this->dir);
+  sorted.reserve(buffer.size());
+}
+
+DigestRunWriter::~DigestRunWriter() {
+  if (writing.valid()) {
+    writing.wait();
+  }
+}
+
+std::span<DigestRecord> DigestRunWriter::append(std::size_t count) {
+  if (count > free_records()) {
+    throw std::length_error("DigestRunWriter::append: run is full");
+  }
+  const std::span<DigestRecord> space(buffer.data() + filled, count);
+  filled += count;
+  return space;
+}
+
+void DigestRunWriter::flush() {
+  if (filled == 0) {
+    return;
+  }
+  // The previous run is still being written from sorted.
+  if (writing.valid()) {
+    writing.get();
+  }
+  sorted.resize(filled);
+  radix_sort_records({buffer.data(), filled}, sorted);
+  filled = 0;
+  paths.push_back(dir / ("run_" + std::to_string(paths.size()) + ".bin"));
+  writing = std::async(std::launch::async,
+                       [this, path = paths.back()]() { write_file(path, sorted); });
+}
+
+const std::vector<std::filesystem::path> &DigestRunWriter::finish() {
+  flush();
+  if (writing.valid()) {
+    writing.get();
+  }
+  return paths;
+}
+
+MergeStats merge_runs(std::span<const std::filesystem::path> runs,
+                      const std::function<void(const DuplicateDigest &)> &on_duplicate) {
+  std::vector<std::unique_ptr<MappedRun>> mapped;
+  mapped.reserve(runs.size());
+  MergeStats stats;
+  for (const auto &path : runs) {
+    mapped.push_back(std::make_unique<MappedRun>(path));
+    stats.bytes += mapped.back()->bytes();
+  }
+
+  // Min-heap of run indices by their front record.
+  auto later = [&](std::size_t a, std::size_t b) {
+    return mapped[b]->front() < mapped[a]->front();
+  };
+  std::priority_queue<std::size_t, std::vector<std::size_t>, decltype(later)> heap(later);
+  for (std::size_t i = 0; i < mapped.size(); ++i) {
+    if (!mapped[i]->empty()) {
+      heap.push(i);
+    }
+  }
+
+  DuplicateDigest group{};
+  auto close_group = [&]() {
+    if (group.sources.size() > 1) {
+      ++stats.duplicate_digests;
+      stats.duplicate_records += group.sources.size();
+      on_duplicate(group);
+    }
+    group.sources.clear();
+  };
+  while (!heap.empty()) {
+    const std::size_t i = heap.top();
+    heap.pop();
+    MappedRun &run = *mapped[i];
+    const DigestRecord record = run.front();
+    run.pop();
+    if (!run.empty()) {
+      if (run.front() < record) {
+        throw std::runtime_error("'" + runs[i].string() + "' is not sorted");
+      }
+      heap.push(i);
+    }
+    ++stats.records;
+    if (group.sources.empty() || group.digest != record.digest) {
+      close_group();
+      group.digest = record.digest;
+    }
+    group.sources.push_back(record.source);
+  }
+  close_group();
+  return stats;
+}
\ No newline at end of file
@@ -0,0 +1,166 @@
+#include <perf_counters.h>
+#include <cerrno>
+#include <cstring>
+
+#if HASHF_HAS_PERF_EVENT
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr std::array<std::string_view, kPerfEventCount> kNames = {
+    "cycles", "instructions", "branch-misses", "L1d-misses", "LLC-misses"};
+
+#if HASHF_HAS_PERF_EVENT
+
+perf_event_attr attr_for(PerfEvent event) {
+  perf_event_attr attr{};
+  attr.size = sizeof(attr);
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  switch (event) {
+  case PerfEvent::cycles:
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CPU_CYCLES;
+    break;
+  case PerfEvent::instructions:
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    break;
+  case PerfEvent::branch_misses:
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+    break;
+  case PerfEvent::l1d_misses:
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8U) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16U);
+    break;
+  case PerfEvent::llc_misses:
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    break;
+  }
+  return attr;
+}
+
+#endif
+
+} // namespace
+
+std::optional<double> PerfSample::ipc() const {
+  const auto cycles = (*this)[PerfEvent::cycles];
+  const auto instructions = (*this)[PerfEvent::instructions];
+  if (!cycles || !instructions || *cycles == 0) {
+    return std::nullopt;
+  }
+  return static_cast<double>(*instructions) / static_cast<double>(*cycles);
+}
+
+std::optional<double> PerfSample::per_byte(PerfEvent event,
+                                           std::size_t bytes) const {
+  const auto value = (*this)[event];
+  if (!value || bytes == 0) {
+    return std::nullopt;
+  }
+  return static_cast<double>(*value) / static_cast<double>(bytes);
+}
+
+PerfSample &PerfSample::operator+=(const PerfSample &other) {
+  for (std::size_t i = 0; i < kPerfEventCount; ++i) {
+    if (values[i] && other.values[i]) {
+      *values[i] += *other.values[i];
+    } else {
+      values[i].reset();
+    }
+  }
+  return *this;
+}
+
+PerfCounters::PerfCounters() {
+  fds.fill(-1);
+#if HASHF_HAS_PERF_EVENT
+  for (std::size_t i = 0; i < kPerfEventCount; ++i) {
+    perf_event_attr attr = attr_for(static_cast<PerfEvent>(i));
+    fds[i] = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1,
+                                        PERF_FLAG_FD_CLOEXEC));
+    if (fds[i] < 0 && failure.empty()) {
+      failure = std::string(kNames[i]) + ": " + std::strerror(errno);
+    }
+  }
+#else
+  failure = "perf_event_open is not available on this platform";
+#endif
+}
+
+PerfCounters::~PerfCounters() {
+#if HASHF_HAS_PERF_EVENT
+  for (const int fd : fds) {
+    if (fd >= 0) {
+      ::close(fd);
+    }
+  }
+#endif
+}
+
+void PerfCounters::start() {
+#if HASHF_HAS_PERF_EVENT
+  for (const int fd : fds) {
+    if (fd >= 0) {
+      ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+      ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+#endif
+}
+
+PerfSample PerfCounters::stop() {
+  PerfSample sample;
+#if HASHF_HAS_PERF_EVENT
+  for (const int fd : fds) {
+    if (fd >= 0) {
+      ::ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+  }
+  for (std::size_t i = 0; i < kPerfEventCount; ++i) {
+    // value, time enabled, time running.
+    std::uint64_t data[3] = {};
+    if (fds[i] < 0 || ::read(fds[i], data, sizeof(data)) != sizeof(data)) {
+      continue;
+    }
+    // Enabled but never scheduled: the count is unknown, not zero.
+    if (data[1] != 0 && data[2] == 0) {
+      continue;
+    }
+    sample.values[i] =
+        data[2] == data[1]
+            ? data[0]
+            : static_cast<std::uint64_t>(static_cast<double>(data[0]) *
+                                         static_cast<double>(data[1]) /
+                                         static_cast<double>(data[2]));
+  }
+#endif
+  return sample;
+}
+
+bool PerfCounters::available() const {
+  for (const int fd : fds) {
+    if (fd >= 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool PerfCounters::available(PerfEvent event) const {
+  return fds[static_cast<std::size_t>(event)] >= 0;
+}
+
+std::string_view PerfCounters::name(PerfEvent event) {
+  return kNames[static_cast<std::size_t>(event)];
+}
\ No newline at end of file
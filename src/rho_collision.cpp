@@ -0,0 +1,84 @@
+#include <rho_collision.h>
+#include <bit>
+#include <cmath>
+#include <iomanip>
+#include <ios>
+#include <numbers>
+#include <thread>
+
+namespace rho {
+
+double expected_evaluations(unsigned bits) {
+  return std::sqrt(std::numbers::pi / 2.0 * std::ldexp(1.0, static_cast<int>(bits)));
+}
+
+unsigned default_distinguished_bits(unsigned bits) {
+  const unsigned half = (bits + 1) / 2;
+  return half > 14 ? half - 14 : 0;
+}
+
+void write_message(std::uint64_t x, unsigned bits, std::string &out) {
+  static constexpr char kDigits[] = "0123456789abcdef";
+  const std::size_t digits = (bits + 3) / 4;
+  out.resize(digits);
+  for (std::size_t i = 0; i < digits; ++i) {
+    out[digits - 1 - i] = kDigits[(x >> (i * 4U)) & 0xFU];
+  }
+}
+
+DistinguishedPointTable::DistinguishedPointTable(std::size_t slots)
+    : slot_count(std::bit_ceil(std::max<std::size_t>(slots, 1))),
+      slots(std::make_unique<Slot[]>(slot_count)) {}
+
+std::optional<DistinguishedPointTable::Trail>
+DistinguishedPointTable::insert(std::uint64_t point, const Trail &trail) {
+  // Points are hash outputs, but their low bits are zero; mix before
+  // picking the first slot.
+  std::size_t index =
+      static_cast<std::size_t>((point * 0x9E3779B97F4A7C15ULL) >> 17U) & (slot_count - 1);
+  for (std::size_t probe = 0; probe < slot_count; ++probe) {
+    Slot &slot = slots[index];
+    std::uint32_t state = slot.state.load(std::memory_order_acquire);
+    if (state == kEmpty &&
+        slot.state.compare_exchange_strong(state, kWriting, std::memory_order_acquire)) {
+      slot.point = point;
+      slot.trail = trail;
+      slot.state.store(kReady, std::memory_order_release);
+      count.fetch_add(1, std::memory_order_relaxed);
+      return std::nullopt;
+    }
+    while (state == kWriting) {
+      std::this_thread::yield();
+      state = slot.state.load(std::memory_order_acquire);
+    }
+    if (slot.point == point) {
+      return slot.trail;
+    }
+    index = (index + 1) & (slot_count - 1);
+  }
+  throw std::length_error("distinguished point table is full");
+}
+
+void write_table(std::ostream &os, std::span<const RhoCollision> results) {
+  os << "| Hasher | Bits | DP bits | Evaluations | Expected | Ratio | Seconds | "
+        "Points | False alarms | Inputs | Digest |\n";
+  os << "| :----- | ---: | ------: | ----------: | -------: | ----: | ------: | "
+        "-----: | -----------: | :----- | :----- |\n";
+  const auto flags = os.flags();
+  const auto precision = os.precision();
+  os.setf(std::ios::fixed, std::ios::floatfield);
+  for (const RhoCollision &r : results) {
+    const double expected = expected_evaluations(r.bits);
+    os << "| " << r.hasher << " | " << r.bits << " | " << r.distinguished_bits << " | "
+       << r.evaluations << " | " << std::setprecision(0) << expected << " | "
+       << std::setprecision(2) << static_cast<double>(r.evaluations) / expected << " | "
+       << std::setprecision(3) << r.seconds << " | " << r.distinguished_points << " | "
+       << r.false_alarms << " | `" << r.first << "` `" << r.second << "` | "
+       << std::hex << std::setw(static_cast<int>((r.bits + 3) / 4)) << std::setfill('0')
+       << r.value << std::dec << std::setfill(' ') << " |\n";
+  }
+  os.flags(flags);
+  os.precision(precision);
+}
+
+} // namespace rho
\ No newline at end of file
@@ -0,0 +1,182 @@
+#include <sac_analyzer.h>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <ios>
+#include <stdexcept>
+
+namespace sac {
+
+namespace {
+
+// Both outcomes of a fair coin are expected n/2 times.
+double coin_chi_squared(std::uint64_t hits, std::uint64_t trials) {
+  if (trials == 0) {
+    return 0.0;
+  }
+  const double expected = static_cast<double>(trials) / 2.0;
+  const double d = static_cast<double>(hits) - expected;
+  return 2.0 * d * d / expected;
+}
+
+std::ofstream open_output(const std::filesystem::path &path) {
+  if (path.has_parent_path()) {
+    std::filesystem::create_directories(path.parent_path());
+  }
+  std::ofstream stream(path, std::ios::trunc);
+  if (!stream) {
+    throw std::runtime_error("failed to open output file '" + path.string() + "'");
+  }
+  return stream;
+}
+
+} // namespace
+
+void DigestBitCounter::flush() {
+  if (pending == 0) {
+    return;
+  }
+  for (std::size_t bit = 0; bit < kDigestBits; ++bit) {
+    std::uint64_t count = 0;
+    for (std::size_t p = 0; p < kPlanes; ++p) {
+      count |= ((planes[p][bit / 64] >> (bit % 64)) & 1U) << p;
+    }
+    counts[bit] += count;
+  }
+  planes = {};
+  pending = 0;
+}
+
+double SacResult::flip_probability(std::size_t in, std::size_t out) const {
+  return samples == 0 ? 0.0
+                      : static_cast<double>(flips[in * kDigestBits + out]) /
+                            static_cast<double>(samples);
+}
+
+double SacResult::bias(std::size_t out) const {
+  return samples == 0 ? 0.0
+                      : static_cast<double>(ones[out]) / static_cast<double>(samples) - 0.5;
+}
+
+double SacResult::bias_chi_squared(std::size_t out) const {
+  return coin_chi_squared(ones[out], samples);
+}
+
+void SacResult::merge(const SacResult &other) {
+  for (std::size_t i = 0; i < flips.size() && i < other.flips.size(); ++i) {
+    flips[i] += other.flips[i];
+  }
+  for (std::size_t i = 0; i < kDigestBits; ++i) {
+    ones[i] += other.ones[i];
+  }
+  for (std::size_t i = 0; i <= kDigestBits; ++i) {
+    distances[i] += other.distances[i];
+  }
+}
+
+double chi_squared_z(double chi_squared, std::size_t degrees) {
+  if (degrees == 0) {
+    return 0.0;
+  }
+  const double k = static_cast<double>(degrees);
+  const double v = 2.0 / (9.0 * k);
+  return (std::cbrt(chi_squared / k) - (1.0 - v)) / std::sqrt(v);
+}
+
+SacSummary summarize(const SacResult &result) {
+  SacSummary s;
+  double probability_sum = 0.0;
+  for (std::size_t in = 0; in < result.input_bits; ++in) {
+    for (std::size_t out = 0; out < kDigestBits; ++out) {
+      const double p = result.flip_probability(in, out);
+      probability_sum += p;
+      if (std::abs(p - 0.5) > s.max_flip_deviation) {
+        s.max_flip_deviation = std::abs(p - 0.5);
+        s.worst_input_bit = in;
+        s.worst_output_bit = out;
+      }
+      s.sac_chi_squared +=
+          coin_chi_squared(result.flips[in * kDigestBits + out], result.samples);
+    }
+  }
+  s.sac_degrees = result.input_bits * kDigestBits;
+  if (s.sac_degrees > 0) {
+    s.mean_flip_probability = probability_sum / static_cast<double>(s.sac_degrees);
+  }
+  s.sac_z = chi_squared_z(s.sac_chi_squared, s.sac_degrees);
+
+  for (std::size_t out = 0; out < kDigestBits; ++out) {
+    if (std::abs(result.bias(out)) > std::abs(s.max_bias)) {
+      s.max_bias = result.bias(out);
+      s.most_biased_bit = out;
+    }
+    s.bias_chi_squared += result.bias_chi_squared(out);
+  }
+  s.bias_z = chi_squared_z(s.bias_chi_squared, kDigestBits);
+
+  std::uint64_t pairs = 0;
+  double distance_sum = 0.0;
+  s.min_distance = kDigestBits;
+  for (std::size_t d = 0; d <= kDigestBits; ++d) {
+    if (result.distances[d] == 0) {
+      continue;
+    }
+    pairs += result.distances[d];
+    distance_sum += static_cast<double>(d) * static_cast<double>(result.distances[d]);
+    s.min_distance = std::min(s.min_distance, d);
+    s.max_distance = std::max(s.max_distance, d);
+  }
+  if (pairs == 0) {
+    s.min_distance = 0;
+  } else {
+    s.mean_distance = distance_sum / static_cast<double>(pairs);
+  }
+  return s;
+}
+
+void write_summary_table(std::ostream &os, std::span<const SacResult> results) {
+  os << "| Hasher | Samples | Input bits | Mean P(flip) | Max dev. from 0.5 | SAC chi2 z | "
+        "Max bias | Bias chi2 | Bias chi2 z | Distance min/avg/max |\n";
+  os << "| :----- | ------: | ---------: | -----------: | ----------: | ---------: | "
+        "-------: | --------: | ----------: | -------------------: |\n";
+  const auto flags = os.flags();
+  const auto precision = os.precision();
+  os.setf(std::ios::fixed, std::ios::floatfield);
+  for (const SacResult &result : results) {
+    const SacSummary s = summarize(result);
+    os << "| " << result.hasher << " | " << result.samples << " | " << result.input_bits
+       << " | " << std::setprecision(5) << s.mean_flip_probability << " | "
+       << s.max_flip_deviation << " (" << s.worst_input_bit << "->" << s.worst_output_bit
+       << ") | " << std::setprecision(2) << s.sac_z << " | " << std::setprecision(5)
+       << s.max_bias << " (bit " << s.most_biased_bit << ") | " << std::setprecision(1)
+       << s.bias_chi_squared << " | " << std::setprecision(2) << s.bias_z << " | "
+       << s.min_distance << '/' << std::setprecision(1) << s.mean_distance << '/'
+       << s.max_distance << " |\n";
+  }
+  os.flags(flags);
+  os.precision(precision);
+}
+
+void write_matrix(const SacResult &result, const std::filesystem::path &path) {
+  std::ofstream stream = open_output(path);
+  stream << std::fixed << std::setprecision(5);
+  for (std::size_t in = 0; in < result.input_bits; ++in) {
+    for (std::size_t out = 0; out < kDigestBits; ++out) {
+      stream << (out == 0 ? "" : " ") << result.flip_probability(in, out);
+    }
+    stream << '\n';
+  }
+}
+
+void write_bias(const SacResult &result, const std::filesystem::path &path) {
+  std::ofstream stream = open_output(path);
+  stream << "Bit Ones Bias Chi2\n" << std::fixed;
+  for (std::size_t out = 0; out < kDigestBits; ++out) {
+    stream << out << ' ' << result.ones[out] << ' ' << std::setprecision(6)
+           << result.bias(out) << ' ' << std::setprecision(3)
+           << result.bias_chi_squared(out) << '\n';
+  }
+}
+
+} // namespace sac
\ No newline at end of file
@@ -0,0 +1,156 @@
+#include <stage_profiler.h>
+#include <array>
+#include <iomanip>
+#include <ios>
+#include <map>
+
+#if HASHF_INSTRUMENT
+#include <algorithm>
+#include <mutex>
+#endif
+
+namespace stage_profiler {
+
+namespace {
+
+struct StageName {
+  std::string_view hasher;
+  std::string_view stage;
+};
+
+constexpr std::array<StageName, kStageCount> kStageNames = {{
+    {"ai", "absorb"},
+    {"ai", "mix_primary"},
+    {"ai", "mix_secondary"},
+    {"ai", "mix_final"},
+    {"ai", "collapse"},
+    {"ai", "to_hex"},
+    {"asmeninis", "absorb"},
+    {"asmeninis", "diffuse"},
+    {"asmeninis", "collapse"},
+    {"asmeninis", "to_hex"},
+}};
+
+#if HASHF_INSTRUMENT
+
+struct Registry {
+  std::mutex mutex;
+  std::vector<ThreadCounters *> live;
+  // Counts of threads that have exited.
+  std::array<std::uint64_t, kStageCount> retired_calls{};
+  std::array<std::uint64_t, kStageCount> retired_cycles{};
+};
+
+// Constructed by the first ThreadCounters, so it outlives all of them.
+Registry &registry() {
+  static Registry instance;
+  return instance;
+}
+
+#endif
+
+} // namespace
+
+#if HASHF_INSTRUMENT
+
+ThreadCounters::ThreadCounters() {
+  Registry &r = registry();
+  std::lock_guard lock(r.mutex);
+  r.live.push_back(this);
+}
+
+ThreadCounters::~ThreadCounters() {
+  Registry &r = registry();
+  std::lock_guard lock(r.mutex);
+  for (std::size_t i = 0; i < kStageCount; ++i) {
+    r.retired_calls[i] += calls[i].load(std::memory_order_relaxed);
+    r.retired_cycles[i] += cycles[i].load(std::memory_order_relaxed);
+  }
+  r.live.erase(std::find(r.live.begin(), r.live.end(), this));
+}
+
+std::vector<StageTotals> report() {
+  // Make sure the calling thread is registered even if it never hashed.
+  (void)thread_counters;
+  Registry &r = registry();
+  std::lock_guard lock(r.mutex);
+  std::vector<StageTotals> totals(kStageCount);
+  for (std::size_t i = 0; i < kStageCount; ++i) {
+    totals[i] = {kStageNames[i].hasher, kStageNames[i].stage, r.retired_calls[i],
+                 r.retired_cycles[i]};
+    for (const ThreadCounters *counters : r.live) {
+      totals[i].calls += counters->calls[i].load(std::memory_order_relaxed);
+      totals[i].cycles += counters->cycles[i].load(std::memory_order_relaxed);
+    }
+  }
+  return totals;
+}
+
+void reset() {
+  (void)thread_counters;
+  Registry &r = registry();
+  std::lock_guard lock(r.mutex);
+  r.retired_calls.fill(0);
+  r.retired_cycles.fill(0);
+  for (ThreadCounters *counters : r.live) {
+    for (std::size_t i = 0; i < kStageCount; ++i) {
+      counters->calls[i].store(0, std::memory_order_relaxed);
+      counters->cycles[i].store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+#else
+
+std::vector<StageTotals> report() { return {}; }
+
+void reset() {}
+
+#endif
+
+std::string_view clock_name() {
+#if defined(__x86_64__) || defined(__i386__)
+  return "tsc";
+#else
+  return "steady_clock_ns";
+#endif
+}
+
+void write_table(std::ostream &os, std::span<const StageTotals> totals) {
+  std::map<std::string_view, std::uint64_t> hasher_cycles;
+  for (const StageTotals &t : totals) {
+    hasher_cycles[t.hasher] += t.cycles;
+  }
+
+  const auto flags = os.flags();
+  const auto precision = os.precision();
+  os << "| Hasher | Stage | Calls | Cycles | Cycles/call | Share % |\n";
+  os << "| :----- | :---- | ----: | -----: | ----------: | ------: |\n";
+  os.setf(std::ios::fixed, std::ios::floatfield);
+  for (const StageTotals &t : totals) {
+    if (t.calls == 0) {
+      continue;
+    }
+    const std::uint64_t all = hasher_cycles[t.hasher];
+    os << "| " << t.hasher << " | " << t.stage << " | " << t.calls << " | "
+       << t.cycles << " | " << std::setprecision(1)
+       << static_cast<double>(t.cycles) / static_cast<double>(t.calls) << " | "
+       << (all == 0 ? 0.0
+                    : 100.0 * static_cast<double>(t.cycles) / static_cast<double>(all))
+       << " |\n";
+  }
+  os.flags(flags);
+  os.precision(precision);
+}
+
+void write_json(std::ostream &os, std::span<const StageTotals> totals) {
+  os << "{\"clock\": \"" << clock_name() << "\", \"stages\": [";
+  for (std::size_t i = 0; i < totals.size(); ++i) {
+    os << (i == 0 ? "\n  " : ",\n  ") << "{\"hasher\": \"" << totals[i].hasher
+       << "\", \"stage\": \"" << totals[i].stage << "\", \"calls\": "
+       << totals[i].calls << ", \"cycles\": " << totals[i].cycles << "}";
+  }
+  os << (totals.empty() ? "]}\n" : "\n]}\n");
+}
+
+} // namespace stage_profiler
\ No newline at end of file
@@ -0,0 +1,225 @@
+#include <thread_pool.h>
+#include <chrono>
+#include <cstdlib>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+thread_local ThreadPool *current_pool = nullptr;
+thread_local std::size_t current_index = 0;
+
+constexpr auto kHelpPollInterval = std::chrono::microseconds(200);
+
+struct GlobalConfig {
+  std::mutex mutex;
+  std::optional<std::pair<unsigned, bool>> requested;
+  bool started = false;
+};
+
+GlobalConfig &global_config() {
+  static GlobalConfig config;
+  return config;
+}
+
+unsigned env_unsigned(const char *name, unsigned fallback) {
+  const char *value = std::getenv(name);
+  if (value == nullptr || *value == '\0') {
+    return fallback;
+  }
+  try {
+    return static_cast<unsigned>(std::stoul(value));
+  } catch (const std::exception &) {
+    return fallback;
+  }
+}
+
+void pin_to_cpu([[maybe_unused]] std::size_t cpu) {
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu % CPU_SETSIZE, &set);
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+}
+
+} // namespace
+
+ThreadPool::ThreadPool(unsigned thread_count, bool pin_threads) {
+  if (thread_count == 0) {
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  }
+  workers.reserve(thread_count);
+  for (unsigned i = 0; i < thread_count; ++i) {
+    workers.push_back(std::make_unique<Worker>());
+  }
+  for (std::size_t i = 0; i < workers.size(); ++i) {
+    workers[i]->thread =
+        std::thread([this, i, pin_threads]() { run_worker(i, pin_threads); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lock(sleep_mutex);
+    stopping.store(true);
+  }
+  wake.notify_all();
+  for (auto &worker : workers) {
+    if (worker->thread.joinable()) {
+      worker->thread.join();
+    }
+  }
+}
+
+ThreadPool &ThreadPool::global() {
+  static ThreadPool &pool = []() -> ThreadPool & {
+    GlobalConfig &config = global_config();
+    std::lock_guard lock(config.mutex);
+    config.started = true;
+    const auto [threads, pin] = config.requested.value_or(std::make_pair(
+        env_unsigned("HASHF_THREADS", 0), env_unsigned("HASHF_PIN_THREADS", 0) != 0));
+    // Intentionally leaked: workers must outlive every static that might
+    // still submit work during shutdown.
+    return *new ThreadPool(threads, pin);
+  }();
+  return pool;
+}
+
+void ThreadPool::configure(unsigned thread_count, bool pin_threads) {
+  GlobalConfig &config = global_config();
+  std::lock_guard lock(config.mutex);
+  if (config.started) {
+    throw std::logic_error("global thread pool already started");
+  }
+  config.requested = std::make_pair(thread_count, pin_threads);
+}
+
+void ThreadPool::push(Task task) {
+  if (current_pool == this) {
+    Worker &self = *workers[current_index];
+    std::lock_guard lock(self.mutex);
+    self.tasks.push_back(std::move(task));
+  } else {
+    std::lock_guard lock(injected_mutex);
+    injected.push_back(std::move(task));
+  }
+  {
+    std::lock_guard lock(sleep_mutex);
+    queued.fetch_add(1, std::memory_order_release);
+  }
+  wake.notify_one();
+}
+
+bool ThreadPool::try_run_one() {
+  Task task;
+  const bool found = current_pool == this
+                         ? (pop_local(current_index, task) ||
+                            steal(current_index, task) || pop_injected(task))
+                         : (pop_injected(task) || steal(workers.size(), task));
+  if (!found) {
+    return false;
+  }
+  queued.fetch_sub(1, std::memory_order_acq_rel);
+  // Counted before the task runs, so a caller that saw it finish sees it.
+  if (current_pool == this) {
+    worker_task_count.fetch_add(1, std::memory_order_relaxed);
+  }
+  task();
+  return true;
+}
+
+void ThreadPool::run_worker(std::size_t index, bool pin) {
+  current_pool = this;
+  current_index = index;
+  if (pin) {
+    pin_to_cpu(index);
+  }
+  while (true) {
+    if (try_run_one()) {
+      continue;
+    }
+    std::unique_lock lock(sleep_mutex);
+    wake.wait(lock, [this]() {
+      return stopping.load() || queued.load(std::memory_order_acquire) > 0;
+    });
+    if (stopping.load() && queued.load(std::memory_order_acquire) == 0) {
+      return;
+    }
+  }
+}
+
+bool ThreadPool::pop_local(std::size_t index, Task &task) {
+  Worker &self = *workers[index];
+  std::lock_guard lock(self.mutex);
+  if (self.tasks.empty()) {
+    return false;
+  }
+  task = std::move(self.tasks.back());
+  self.tasks.pop_back();
+  return true;
+}
+
+bool ThreadPool::steal(std::size_t thief, Task &task) {
+  const std::size_t count = workers.size();
+  for (std::size_t offset = 1; offset <= count; ++offset) {
+    const std::size_t victim = (thief + offset) % count;
+    if (victim == thief) {
+      continue;
+    }
+    Worker &worker = *workers[victim];
+    std::lock_guard lock(worker.mutex);
+    if (!worker.tasks.empty()) {
+      task = std::move(worker.tasks.front());
+      worker.tasks.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ThreadPool::pop_injected(Task &task) {
+  std::lock_guard lock(injected_mutex);
+  if (injected.empty()) {
+    return false;
+  }
+  task = std::move(injected.front());
+  injected.pop_front();
+  return true;
+}
+
+TaskGroup::~TaskGroup() {
+  try {
+    wait();
+  } catch (...) {
+  }
+}
+
+void TaskGroup::wait() {
+  while (pending.load(std::memory_order_acquire) != 0) {
+    if (pool.try_run_one()) {
+      continue;
+    }
+    std::unique_lock lock(mutex);
+    done.wait_for(lock, kHelpPollInterval, [this]() {
+      return pending.load(std::memory_order_acquire) == 0;
+    });
+  }
+  std::lock_guard lock(mutex);
+  if (error) {
+    std::rethrow_exception(std::exchange(error, nullptr));
+  }
+}
+
+void TaskGroup::finish_one() {
+  std::lock_guard lock(mutex);
+  if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    done.notify_all();
+  }
+}
\ No newline at end of file
@@ -1,26 +1,89 @@
-#include <bitset>
-#include <cctype>
+#include <hex.h>
+#include <utils.h>
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <cstddef>
 #include <cstdint>
-#include <iostream>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 #include <vector>
-const char dict[] = "0123456789abcdef";
-size_t get_hex_index(char letter) {
-  for (size_t i = 0; i < 16; i++) {
-    if (std::tolower(letter) == dict[i])
-      return i;
+
+namespace {
+
+struct DiffCounts {
+  int bits = 0;
+  int digits = 0;
+};
+
+[[noreturn]] void throw_bad_digit(const char *which, std::string_view hash,
+                                  std::size_t offset) {
+  std::ostringstream msg;
+  msg << which << ": invalid hex character '" << hash[offset] << "' at offset "
+      << offset;
+  throw std::invalid_argument(msg.str());
+}
+
+void decode_chunk(const char *which, std::string_view hash, std::size_t at,
+                  std::size_t length, std::uint8_t *out) {
+  std::size_t bad = 0;
+  if (!hex_decode(hash.substr(at, length), out, &bad)) {
+    throw_bad_digit(which, hash, at + bad);
   }
-  throw;
 }
-std::vector<unsigned char> hex_to_ascii(const std::string &input) {
-  std::vector<unsigned char> output;
-  for (int i = 0; i < input.size(); i += 2) {
-    char a = input[i];
-    char b = input[i + 1];
-    size_t a_num = get_hex_index(a);
-    size_t b_num = get_hex_index(b);
-    output.push_back(static_cast<unsigned char>((a_num << 4) | b_num));
+
+int digit_at(const char *which, std::string_view hash, std::size_t offset) {
+  if (offset >= hash.size()) {
+    return 0;
+  }
+  const int value = hex_value(hash[offset]);
+  if (value < 0) {
+    throw_bad_digit(which, hash, offset);
+  }
+  return value;
+}
+
+// Whole bytes are decoded through the shared codec a chunk at a time; only
+// an odd or unmatched tail is handled digit by digit.
+DiffCounts diff_counts(std::string_view hash1, std::string_view hash2) {
+  constexpr std::size_t kChunkDigits = 128;
+  std::array<std::uint8_t, kChunkDigits / 2> lhs;
+  std::array<std::uint8_t, kChunkDigits / 2> rhs;
+  const std::size_t paired = std::min(hash1.size(), hash2.size()) & ~std::size_t{1};
+
+  DiffCounts counts;
+  for (std::size_t at = 0; at < paired; at += kChunkDigits) {
+    const std::size_t length = std::min(kChunkDigits, paired - at);
+    decode_chunk("hash1", hash1, at, length, lhs.data());
+    decode_chunk("hash2", hash2, at, length, rhs.data());
+    for (std::size_t i = 0; i < length / 2; ++i) {
+      const auto diff = static_cast<std::uint8_t>(lhs[i] ^ rhs[i]);
+      counts.bits += std::popcount(diff);
+      counts.digits += ((diff & 0xF0U) != 0) + ((diff & 0x0FU) != 0);
+    }
   }
-  return output;
+
+  const std::size_t common = std::min(hash1.size(), hash2.size());
+  for (std::size_t i = paired; i < std::max(hash1.size(), hash2.size()); ++i) {
+    const auto diff = static_cast<unsigned>(digit_at("hash1", hash1, i) ^
+                                            digit_at("hash2", hash2, i));
+    counts.bits += std::popcount(diff);
+    counts.digits += i >= common || diff != 0;
+  }
+  return counts;
+}
+
+} // namespace
+
+std::vector<unsigned char> hex_to_ascii(const std::string &input) {
+  return hex_decode(input);
+}
+
+int bit_diff(std::string_view hash1, std::string_view hash2) {
+  return diff_counts(hash1, hash2).bits;
+}
+
+int hex_diff(std::string_view hash1, std::string_view hash2) {
+  return diff_counts(hash1, hash2).digits;
 }
\ No newline at end of file
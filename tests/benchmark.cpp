@@ -1,8 +1,8 @@
 #include "AIHasher.h"
-#include "Hasher.h"
-#include <Timer.h>
+#include "benchmark_modes.h"
+#include "hasher_registry.h"
+#include "throughput_sweep.h"
 #include <algorithm>
-#include <array>
 #include <constants.h>
 #include <cstddef>
 #include <filesystem>
@@ -12,21 +12,20 @@
 #include <iostream>
 #include <limits>
 #include <map>
-#include <memory>
 #include <optional>
+#include <perf_counters.h>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread_pool.h>
 #include <tuple>
+#include <utils.h>
 #include <vector>
 
 namespace {
 
 using Path = std::filesystem::path;
 
-constexpr std::array<int, 16> kNibblePopcount = {0, 1, 1, 2, 1, 2, 2, 3,
-                                                 1, 2, 2, 3, 2, 3, 3, 4};
-
 [[nodiscard]] std::vector<Path> collect_regular_files(const Path &target) {
   if (!std::filesystem::exists(target)) {
     std::ostringstream msg;
@@ -82,13 +81,6 @@ constexpr std::array<int, 16> kNibblePopcount = {0, 1, 1, 2, 1, 2, 2, 3,
   return stream;
 }
 
-[[nodiscard]] std::string format_seconds(double value) {
-  std::ostringstream oss;
-  oss << std::fixed
-      << std::setprecision(std::numeric_limits<double>::max_digits10) << value;
-  return oss.str();
-}
-
 struct base_test_info {
   int line_count;
   int symbol_count;
@@ -183,39 +175,84 @@ void print_avalanche_md_table(const std::vector<avalanche_info> &entries,
 
 } // namespace
 
-void collision_search(const std::string &label, const IHasher &hasher,
+// The search loops are templated on the concrete hasher so the per-input
+// hash256bit call is bound statically; main picks the type by name through
+// HasherRegistry::visit.
+template <ConcreteHasher H>
+void collision_search(const std::string &label, const H &hasher,
                       const std::filesystem::path &dir,
                       std::vector<collision_info> *results = nullptr);
-void avalanche_search(const std::string &label, const IHasher &hasher,
+template <ConcreteHasher H>
+void avalanche_search(const std::string &label, const H &hasher,
                       const std::filesystem::path &dir,
                       std::vector<avalanche_info> *results = nullptr,
                       std::optional<int> first_n = std::nullopt);
-std::vector<std::pair<int, double>>
-test_konstitucija(const IHasher &hasher, const std::filesystem::path &dir,
-                  int test_count = 5);
-int bit_diff(const std::string &hash1, const std::string &hash2);
-int hex_diff(const std::string &hash1, const std::string &hash2);
-
 int main(int argc, char *argv[]) {
-  std::vector<std::pair<std::string, std::unique_ptr<IHasher>>> hashers;
-  hashers.emplace_back("asmeninis", std::make_unique<Hasher>());
-  hashers.emplace_back("ai", std::make_unique<AIHasher>());
+  const std::vector<std::string> hashers = {"asmeninis", "ai"};
 
   if (argc > 1 && std::string(argv[1]) == "test") {
     std::cout << "starting small avalanche test..\n";
     std::vector<avalanche_info> sample_results;
-  avalanche_search(hashers.front().first, *hashers.front().second,
-           kAvalanchePath / "avalanche_pairs_1000_100000.txt",
-           &sample_results, 10);
+    HasherRegistry::visit(hashers.front(), [&](const auto &hasher) {
+      avalanche_search(hashers.front(), hasher,
+                       kAvalanchePath / "avalanche_pairs_1000_100000.txt",
+                       &sample_results, 10);
+    });
     std::cout << "finished, exiting..\n";
     return 0;
   }
+  // Mode names are hashed at compile time; an unknown argument falls through
+  // to the full benchmark.
+  switch (argc > 1 ? AIHasher::key64(argv[1]) : 0) {
+  case "validate"_ai64:
+    return benchmark_chain_validation(argc, argv);
+  case "verify"_ai64:
+    return benchmark_transaction_verification(argc, argv);
+  case "mempool"_ai64:
+    return benchmark_mempool(argc, argv);
+  case "tree"_ai64:
+    return benchmark_tree_hashing(argc, argv);
+  case "sha256"_ai64:
+    return benchmark_sha256_short(argc, argv);
+  case "hashmap"_ai64:
+    return benchmark_hash_map(argc, argv);
+  case "dispatch"_ai64:
+    return benchmark_dispatch(argc, argv);
+  case "hex"_ai64:
+    return benchmark_hex(argc, argv);
+  case "cdc"_ai64:
+    return benchmark_chunk_store(argc, argv);
+  case "read"_ai64:
+    return benchmark_file_reading(argc, argv);
+  case "stages"_ai64:
+    return benchmark_stages(argc, argv);
+  case "latency"_ai64:
+    return benchmark_latency(argc, argv);
+  case "record"_ai64:
+    return benchmark_record(argc, argv);
+  case "compare"_ai64:
+    return benchmark_compare(argc, argv);
+  case "throughput"_ai64:
+    return benchmark_throughput(argc, argv);
+  case "sac"_ai64:
+    return benchmark_sac(argc, argv);
+  case "rho"_ai64:
+    return benchmark_rho(argc, argv);
+  case "external"_ai64:
+    return benchmark_external(argc, argv);
+  default:
+    break;
+  }
 
-  std::map<int, std::map<std::string, double>> konstitucija_times;
   std::map<std::string, std::vector<avalanche_info>> avalanche_results;
   std::map<std::string, std::vector<collision_info>> collision_results;
 
-  std::cout << "starting konstitucija test..\n";
+  std::cout << "starting throughput sweep..\n";
+  PerfCounters counters;
+  if (!counters.available()) {
+    std::cout << "hardware counters unavailable (" << counters.reason()
+              << "), reporting time only\n";
+  }
 
   std::ofstream oss;
   bool write_summary_to_file = false;
@@ -237,26 +274,38 @@ int main(int argc, char *argv[]) {
            std::tie(rhs.symbol_count, rhs.line_count);
   };
 
-  for (auto &entry : hashers) {
-    const std::string &label = entry.first;
-    IHasher &hasher = *entry.second;
+  // konstitucija.txt repeated up to 16 MiB, every hasher on the whole pool.
+  SweepOptions sweep;
+  sweep.max_bytes = std::size_t{16} << 20U;
+  sweep.text = true;
+  sweep.hashers = hashers;
+  try {
+    const auto points =
+        throughput_sweep(sweep, counters.available() ? &counters : nullptr);
+    std::cout << "\nThroughput:\n";
+    print_sweep_md_table(points);
+    if (write_summary_to_file) {
+      oss << "\n## Throughput\n";
+      print_sweep_md_table(points, oss);
+    }
+    write_sweep_chart_data(points, kResultsPath / "throughput.txt");
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << '\n';
+  }
 
+  for (const std::string &label : hashers) {
     std::cout << "\n== " << label << " ==\n";
 
-    const auto timings = test_konstitucija(hasher, kKonstitucijaPath);
-    for (const auto &[line_count, elapsed] : timings) {
-      konstitucija_times[line_count][label] = elapsed;
-      std::cout << "lines: " << line_count << ", time: "
-                << format_seconds(elapsed) << '\n';
-    }
-
     std::vector<avalanche_info> avalanche_data;
-  avalanche_search(label, hasher, kAvalanchePath, &avalanche_data);
+    std::vector<collision_info> collision_data;
+    HasherRegistry::visit(label, [&](const auto &hasher) {
+      avalanche_search(label, hasher, kAvalanchePath, &avalanche_data);
+      collision_search(label, hasher, kCollisionPath, &collision_data);
+    });
+
     std::sort(avalanche_data.begin(), avalanche_data.end(), avalanche_cmp);
     avalanche_results[label] = avalanche_data;
 
-    std::vector<collision_info> collision_data;
-  collision_search(label, hasher, kCollisionPath, &collision_data);
     std::sort(collision_data.begin(), collision_data.end(), collision_cmp);
     collision_results[label] = collision_data;
 
@@ -279,91 +328,45 @@ int main(int argc, char *argv[]) {
     }
   }
 
-  const auto results_file = kResultsPath / "konstitucija.txt";
-  try {
-    std::ofstream konstitucija_stream = open_ofstream(results_file);
-    konstitucija_stream << "Lines";
-    for (const auto &entry : hashers) {
-      konstitucija_stream << ' ' << entry.first;
-    }
-    konstitucija_stream << '\n';
-    for (const auto &[line_count, timings] : konstitucija_times) {
-      konstitucija_stream << line_count;
-      for (const auto &entry : hashers) {
-        const auto it = timings.find(entry.first);
-        const double value = it == timings.end() ? 0.0 : it->second;
-        konstitucija_stream << ' ' << format_seconds(value);
-      }
-      konstitucija_stream << '\n';
-    }
-  } catch (const std::exception &e) {
-    std::cerr << e.what() << '\n';
-  }
-
-  std::cout << "konstitucija tests finished!\n";
+  std::cout << "benchmark finished!\n";
 }
 
-std::vector<std::pair<int, double>>
-test_konstitucija(const IHasher &hasher, const std::filesystem::path &dir,
-                  int test_count) {
-  if (!std::filesystem::is_regular_file(dir)) {
-    std::ostringstream msg;
-    msg << "konstitucija path '" << dir << "' must be a regular file";
-    throw std::runtime_error(msg.str());
-  }
+namespace {
 
-  auto input = open_ifstream(dir);
+using word_pair = std::pair<std::string, std::string>;
 
-  std::vector<std::string> lines;
-  std::string line;
-  while (std::getline(input, line)) {
-    lines.push_back(line + '\n');
+std::vector<word_pair> read_pairs(std::ifstream &iss,
+                                  std::optional<int> first_n = std::nullopt) {
+  std::vector<word_pair> pairs;
+  std::string word1;
+  std::string word2;
+  while ((!first_n || static_cast<int>(pairs.size()) < *first_n) &&
+         iss >> word1 >> word2) {
+    pairs.emplace_back(std::move(word1), std::move(word2));
   }
-  if (lines.empty()) {
-    throw std::runtime_error("konstitucija file is empty");
-  }
-
-  std::map<int, double> times;
-  hasher.hash256bit("");
-
-  const int total_lines = static_cast<int>(lines.size());
-  std::string buffer;
-  buffer.reserve(static_cast<std::size_t>(total_lines) * 64U);
-
-  for (int iter = 0; iter < test_count; ++iter) {
-    for (int block = 1; block <= total_lines; block *= 2) {
-      const int limit = std::min(block, total_lines);
-      buffer.clear();
-      for (int i = 0; i < limit; ++i) {
-        buffer.append(lines[static_cast<std::size_t>(i)]);
-      }
-
-      Timer t;
-      hasher.hash256bit(buffer);
-      times[limit] += t.elapsed();
-    }
+  return pairs;
+}
 
-    buffer.clear();
-    for (const auto &entry : lines) {
-      buffer.append(entry);
-    }
-    Timer t;
-    hasher.hash256bit(buffer);
-    times[total_lines] += t.elapsed();
-  }
+// Hashes both words of every pair on the shared pool; results line up with
+// the input so the caller can aggregate sequentially.
+template <ConcreteHasher H>
+std::vector<word_pair> hash_pairs(const H &hasher,
+                                  const std::vector<word_pair> &pairs) {
+  std::vector<word_pair> hashes(pairs.size());
+  ThreadPool::global().parallel_for(
+      pairs.size(), 256, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+          hashes[i] = {hasher.hash256bit(pairs[i].first),
+                       hasher.hash256bit(pairs[i].second)};
+        }
+      });
+  return hashes;
+}
 
-  for (auto &time_entry : times) {
-    time_entry.second /= static_cast<double>(test_count);
-  }
+} // namespace
 
-  std::vector<std::pair<int, double>> results;
-  results.reserve(times.size());
-  for (const auto &[line_count, elapsed] : times) {
-    results.emplace_back(line_count, elapsed);
-  }
-  return results;
-}
-void collision_search(const std::string &label, const IHasher &hasher,
+template <ConcreteHasher H>
+void collision_search(const std::string &label, const H &hasher,
                       const std::filesystem::path &dir,
                       std::vector<collision_info> *results) {
   std::vector<std::filesystem::path> paths;
@@ -392,17 +395,16 @@ void collision_search(const std::string &label, const IHasher &hasher,
       continue;
     }
 
-    std::string word1;
-    std::string word2;
-    while (iss >> word1 >> word2) {
+    const std::vector<word_pair> pairs = read_pairs(iss);
+    const std::vector<word_pair> hashes = hash_pairs(hasher, pairs);
+    for (std::size_t i = 0; i < pairs.size(); ++i) {
+      const auto &[word1, word2] = pairs[i];
       line_cnt++;
       if (!symbol_count_found) {
         symbol_cnt = static_cast<int>(word1.size());
         symbol_count_found = true;
       }
-      const std::string hash1 = hasher.hash256bit(word1);
-      const std::string hash2 = hasher.hash256bit(word2);
-      if (hash1 == hash2 && word1 != word2) {
+      if (hashes[i].first == hashes[i].second && word1 != word2) {
         collision_count += 1;
         collision_pairs.emplace_back(word1, word2);
       }
@@ -427,7 +429,8 @@ void collision_search(const std::string &label, const IHasher &hasher,
     }
   }
 }
-void avalanche_search(const std::string &label, const IHasher &hasher,
+template <ConcreteHasher H>
+void avalanche_search(const std::string &label, const H &hasher,
                       const std::filesystem::path &dir,
                       std::vector<avalanche_info> *results,
                       std::optional<int> first_n) {
@@ -462,14 +465,16 @@ void avalanche_search(const std::string &label, const IHasher &hasher,
       continue;
     }
 
-    std::string word1, word2;
-    while (iss >> word1 >> word2) {
+    const std::vector<word_pair> pairs = read_pairs(iss, first_n);
+    const std::vector<word_pair> hashes = hash_pairs(hasher, pairs);
+    for (std::size_t i = 0; i < pairs.size(); ++i) {
+      const auto &[word1, word2] = pairs[i];
       if (!symbol_count_found) {
         symbol_cnt = static_cast<int>(word1.size());
         symbol_count_found = true;
       }
-      std::string hash1 = hasher.hash256bit(word1);
-      std::string hash2 = hasher.hash256bit(word2);
+      const std::string &hash1 = hashes[i].first;
+      const std::string &hash2 = hashes[i].second;
       int hex_diffs = hex_diff(hash1, hash2);
       int bit_diffs = bit_diff(hash1, hash2);
       double hex_pct = static_cast<double>(hex_diffs) / 64.0 * 100.0;
@@ -490,9 +495,6 @@ void avalanche_search(const std::string &label, const IHasher &hasher,
       ++line_cnt;
       if (line_cnt % 10000 == 0)
         std::cout << "did 10k\n";
-      if (first_n && line_cnt >= *first_n) {
-        break;
-      }
     }
     if (line_cnt == 0) {
       std::cerr << "No pairs found in " << path << '\n';
@@ -524,56 +526,4 @@ void avalanche_search(const std::string &label, const IHasher &hasher,
     oss << "avg: " << avg_bit_pct << ", min: " << min_bit_pct
         << ", max: " << max_bit_pct << '\n';
   }
-}
-int bit_diff(const std::string &hash1, const std::string &hash2) {
-  constexpr auto hex_val = [](char c) -> int {
-    if (c >= '0' && c <= '9')
-      return c - '0';
-    if (c >= 'a' && c <= 'f')
-      return 10 + (c - 'a');
-    if (c >= 'A' && c <= 'F')
-      return 10 + (c - 'A');
-    throw std::invalid_argument("Invalid hex character in hash string");
-  };
-
-  const std::size_t max_len = std::max(hash1.size(), hash2.size());
-  int diff = 0;
-  for (std::size_t i = 0; i < max_len; ++i) {
-    const int v1 = i < hash1.size() ? hex_val(hash1[i]) : 0;
-    const int v2 = i < hash2.size() ? hex_val(hash2[i]) : 0;
-    diff += kNibblePopcount[static_cast<std::size_t>((v1 ^ v2) & 0x0F)];
-  }
-  return diff;
-}
-int hex_diff(const std::string &hash1, const std::string &hash2) {
-  auto is_hex_digit = [](char c) {
-    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') ||
-           (c >= 'A' && c <= 'F');
-  };
-  auto normalize = [](char c) {
-    return (c >= 'A' && c <= 'F') ? static_cast<char>(c - 'A' + 'a') : c;
-  };
-
-  for (char c : hash1) {
-    if (!is_hex_digit(c)) {
-      throw std::invalid_argument("hash1 contains non-hex character");
-    }
-  }
-  for (char c : hash2) {
-    if (!is_hex_digit(c)) {
-      throw std::invalid_argument("hash2 contains non-hex character");
-    }
-  }
-
-  const std::size_t min_len = std::min(hash1.size(), hash2.size());
-  int diff = 0;
-
-  for (std::size_t i = 0; i < min_len; ++i) {
-    if (normalize(hash1[i]) != normalize(hash2[i])) {
-      ++diff;
-    }
-  }
-
-  diff += static_cast<int>(std::max(hash1.size(), hash2.size()) - min_len);
-  return diff;
 }
\ No newline at end of file
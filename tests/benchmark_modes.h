@@ -0,0 +1,20 @@
+#pragma once
+
+int benchmark_chain_validation(int argc, char *argv[]);
+int benchmark_transaction_verification(int argc, char *argv[]);
+int benchmark_mempool(int argc, char *argv[]);
+int benchmark_tree_hashing(int argc, char *argv[]);
+int benchmark_sha256_short(int argc, char *argv[]);
+int benchmark_hash_map(int argc, char *argv[]);
+int benchmark_dispatch(int argc, char *argv[]);
+int benchmark_hex(int argc, char *argv[]);
+int benchmark_chunk_store(int argc, char *argv[]);
+int benchmark_file_reading(int argc, char *argv[]);
+int benchmark_stages(int argc, char *argv[]);
+int benchmark_latency(int argc, char *argv[]);
+int benchmark_record(int argc, char *argv[]);
+int benchmark_compare(int argc, char *argv[]);
+int benchmark_throughput(int argc, char *argv[]);
+int benchmark_sac(int argc, char *argv[]);
+int benchmark_rho(int argc, char *argv[]);
+int benchmark_external(int argc, char *argv[]);
\ No newline at end of file
@@ -0,0 +1,261 @@
+#include <crypto/blockchain.h>
+#include <crypto/mempool.h>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+namespace {
+
+std::vector<Transaction> make_transactions(int count) {
+  std::vector<Transaction> txs;
+  for (int i = 0; i < count; ++i) {
+    txs.push_back(make_transaction("", "miner", static_cast<uint64_t>(i + 1)));
+  }
+  return txs;
+}
+
+Blockchain make_chain(int length, int txs_per_block) {
+  Blockchain chain(Block(make_transactions(txs_per_block), "", 0));
+  for (int i = 1; i < length; ++i) {
+    Block block(make_transactions(txs_per_block), chain.tip().block_hash, 0);
+    EXPECT_TRUE(chain.add_block(std::move(block)));
+  }
+  return chain;
+}
+
+} // namespace
+
+TEST(BlockchainTest, HeightIndexedAccess) {
+  const Blockchain chain = make_chain(50, 3);
+  ASSERT_EQ(chain.size(), 50U);
+  for (std::size_t h = 1; h < chain.size(); ++h) {
+    EXPECT_EQ(chain.at(h).previous_block_hash, chain.at(h - 1).block_hash);
+    ASSERT_EQ(chain.at(h).transactions.size(), 3U);
+    EXPECT_EQ(chain.at(h).transactions[2].amount, 3U);
+  }
+  EXPECT_THROW((void)chain.at(50), std::out_of_range);
+}
+
+TEST(BlockchainTest, HashLookupReturnsHeight) {
+  const Blockchain chain = make_chain(2000, 1);
+  for (std::size_t h = 0; h < chain.size(); h += 97) {
+    const auto found = chain.find(chain.at(h).block_hash);
+    ASSERT_TRUE(found.has_value());
+    EXPECT_EQ(*found, h);
+  }
+  EXPECT_FALSE(chain.find("not a block hash").has_value());
+}
+
+TEST(BlockchainTest, RejectsBlockNotLinkedToTip) {
+  Blockchain chain = make_chain(3, 1);
+  Block orphan(make_transactions(1), chain.at(0).block_hash, 0);
+  EXPECT_FALSE(chain.add_block(orphan));
+  EXPECT_FALSE(chain.add_block(std::unique_ptr<Block>{}));
+  EXPECT_EQ(chain.size(), 3U);
+}
+
+TEST(BlockchainTest, RecordsSurviveChunkGrowth) {
+  Blockchain chain = make_chain(1, 1);
+  const BlockRecord *genesis = &chain.at(0);
+  const Transaction *first_tx = chain.at(0).transactions.data();
+  for (int i = 1; i < 3000; ++i) {
+    ASSERT_TRUE(chain.add_block(
+        Block(make_transactions(5), chain.tip().block_hash, 0)));
+  }
+  EXPECT_EQ(genesis, &chain.at(0));
+  EXPECT_EQ(first_tx, chain.at(0).transactions.data());
+
+  Blockchain moved = std::move(chain);
+  EXPECT_EQ(moved.find(moved.at(1234).block_hash), 1234U);
+}
+
+TEST(BlockTest, MiningMeetsDifficulty) {
+  Block block(make_transactions(2), "", 2);
+  const std::string hash = block.mine_block();
+  EXPECT_TRUE(Block::meets_difficulty(hash, 2));
+  EXPECT_EQ(hash, block.to_hash());
+}
+
+TEST(BlockchainTest, ValidateAcceptsWellFormedChain) {
+  const Blockchain chain = make_chain(5000, 2);
+  std::size_t last_done = 0;
+  std::size_t reported_total = 0;
+  const ValidationResult result = chain.validate(
+      [&](std::size_t done, std::size_t total) {
+        EXPECT_GE(done, last_done);
+        last_done = done;
+        reported_total = total;
+      },
+      4);
+  EXPECT_TRUE(result.valid);
+  EXPECT_FALSE(result.first_invalid_height.has_value());
+  EXPECT_EQ(last_done, chain.size());
+  EXPECT_EQ(reported_total, chain.size());
+}
+
+TEST(BlockchainTest, ValidateReportsFirstUnminedBlock) {
+  Blockchain chain = make_chain(300, 1);
+  Block unmined(make_transactions(1), chain.tip().block_hash, 8);
+  ASSERT_FALSE(Block::meets_difficulty(unmined.block_hash(), 8));
+  ASSERT_TRUE(chain.add_block(unmined));
+  for (int i = 1; i < 300; ++i) {
+    ASSERT_TRUE(chain.add_block(
+        Block(make_transactions(1), chain.tip().block_hash, 0)));
+  }
+
+  for (unsigned threads : {1u, 3u, 8u}) {
+    const ValidationResult result = chain.validate({}, threads);
+    EXPECT_FALSE(result.valid);
+    ASSERT_TRUE(result.first_invalid_height.has_value());
+    EXPECT_EQ(*result.first_invalid_height, 300U);
+    EXPECT_EQ(result.reason, "block hash does not meet difficulty");
+  }
+}
+
+
+TEST(BalanceIndexTest, TracksBalancesAcrossBlocks) {
+  Blockchain chain(Block({make_transaction("", "alice", 100)}, "", 0));
+  ASSERT_TRUE(chain.add_block(Block(
+      {make_transaction("alice", "bob", 30), make_transaction("bob", "carol", 10)},
+      chain.tip().block_hash, 0)));
+  EXPECT_EQ(chain.balances().balance("alice"), 70U);
+  EXPECT_EQ(chain.balances().balance("bob"), 20U);
+  EXPECT_EQ(chain.balances().balance("carol"), 10U);
+  EXPECT_EQ(chain.balances().balance("nobody"), 0U);
+  EXPECT_EQ(chain.balances().users().size(), 3U);
+}
+
+TEST(BalanceIndexTest, RejectsOverdraftAtomically) {
+  Blockchain chain(Block({make_transaction("", "alice", 50)}, "", 0));
+  const std::string tip = chain.tip().block_hash;
+  EXPECT_FALSE(chain.add_block(Block(
+      {make_transaction("alice", "bob", 40), make_transaction("alice", "bob", 11)},
+      tip, 0)));
+  EXPECT_EQ(chain.size(), 1U);
+  EXPECT_EQ(chain.balances().balance("alice"), 50U);
+  EXPECT_EQ(chain.balances().balance("bob"), 0U);
+}
+
+TEST(BalanceIndexTest, RejectsCreditOverflowAtomically) {
+  constexpr std::uint64_t kMax = std::numeric_limits<std::uint64_t>::max();
+  BalanceIndex balances;
+  ASSERT_TRUE(balances.apply_block(std::vector{make_transaction("", "alice", kMax)}));
+  std::size_t failed = 0;
+  BalanceError error = BalanceError::overdraft;
+  EXPECT_FALSE(balances.apply_block(
+      std::vector{make_transaction("", "bob", 5), make_transaction("bob", "alice", 1)},
+      &failed, &error));
+  EXPECT_EQ(failed, 1U);
+  EXPECT_EQ(error, BalanceError::overflow);
+  EXPECT_EQ(balances.balance("alice"), kMax);
+  EXPECT_EQ(balances.balance("bob"), 0U);
+  EXPECT_TRUE(balances.apply_block(std::vector{make_transaction("alice", "alice", kMax)}));
+}
+
+TEST(BalanceIndexTest, PopBlockRollsBackBalances) {
+  Blockchain chain(Block({make_transaction("", "alice", 100)}, "", 0));
+  ASSERT_TRUE(chain.add_block(
+      Block({make_transaction("alice", "bob", 60)}, chain.tip().block_hash, 0)));
+  const std::string popped_hash = chain.tip().block_hash;
+  chain.pop_block();
+  EXPECT_EQ(chain.size(), 1U);
+  EXPECT_FALSE(chain.find(popped_hash).has_value());
+  EXPECT_EQ(chain.balances().balance("alice"), 100U);
+  EXPECT_EQ(chain.balances().balance("bob"), 0U);
+
+  ASSERT_TRUE(chain.add_block(
+      Block({make_transaction("alice", "carol", 25)}, chain.tip().block_hash, 0)));
+  EXPECT_EQ(chain.balances().balance("alice"), 75U);
+  EXPECT_EQ(chain.balances().balance("carol"), 25U);
+  EXPECT_THROW(Blockchain(Block({}, "", 0)).pop_block(), std::logic_error);
+}
+
+TEST(TransactionVerifierTest, RejectsTamperedTxid) {
+  Blockchain chain(Block({make_transaction("", "alice", 100)}, "", 0));
+  Transaction forged = make_transaction("alice", "bob", 10);
+  forged.amount = 90;
+  EXPECT_FALSE(chain.add_block(Block({make_transaction("", "bob", 1), forged},
+                                     chain.tip().block_hash, 0)));
+  EXPECT_EQ(chain.last_verification().first_invalid_index, 1U);
+  EXPECT_EQ(chain.last_verification().reason,
+            "txid does not match transaction contents");
+  EXPECT_EQ(chain.balances().balance("bob"), 0U);
+}
+
+TEST(TransactionVerifierTest, RejectsDuplicateTxidInBlock) {
+  Blockchain chain(Block({make_transaction("", "alice", 100)}, "", 0));
+  const Transaction spend = make_transaction("alice", "bob", 10);
+  EXPECT_FALSE(
+      chain.add_block(Block({spend, spend}, chain.tip().block_hash, 0)));
+  EXPECT_EQ(chain.last_verification().reason, "duplicate txid within block");
+  EXPECT_EQ(chain.balances().balance("alice"), 100U);
+}
+
+TEST(TransactionVerifierTest, ParallelStagesMatchSequential) {
+  std::vector<Transaction> txs;
+  txs.push_back(make_transaction("", "bank", 1'000'000'000));
+  for (int i = 0; i < 20000; ++i) {
+    txs.push_back(make_transaction("bank", "user" + std::to_string(i % 500),
+                                   static_cast<uint64_t>(i + 1)));
+  }
+  for (unsigned threads : {1u, 4u}) {
+    BalanceIndex balances;
+    const VerificationResult result =
+        TransactionVerifier(threads).verify(txs, balances);
+    ASSERT_TRUE(result.valid) << result.reason;
+    EXPECT_GT(balances.balance("user7"), 0U);
+    EXPECT_GE(result.timings.total(), 0.0);
+  }
+
+  txs.push_back(make_transaction("user3", "bank", 1'000'000'000));
+  BalanceIndex balances;
+  const VerificationResult result = TransactionVerifier(4).verify(txs, balances);
+  EXPECT_FALSE(result.valid);
+  EXPECT_EQ(result.first_invalid_index, txs.size() - 1U);
+  EXPECT_EQ(result.reason, "sender balance too low");
+  EXPECT_EQ(balances.applied_blocks(), 0U);
+}
+
+TEST(MempoolTest, TemplateOrdersByFeeBucket) {
+  Mempool pool(100);
+  const Transaction low = make_transaction("alice", "bob", 1);
+  const Transaction mid = make_transaction("alice", "bob", 2);
+  const Transaction high = make_transaction("alice", "bob", 3);
+  EXPECT_TRUE(pool.add(low, 1));
+  EXPECT_TRUE(pool.add(high, 5000));
+  EXPECT_TRUE(pool.add(mid, 40));
+  EXPECT_FALSE(pool.add(mid, 40));
+
+  const auto block_txs = pool.build_template(2);
+  ASSERT_EQ(block_txs.size(), 2U);
+  EXPECT_EQ(block_txs[0].txid, high.txid);
+  EXPECT_EQ(block_txs[1].txid, mid.txid);
+
+  Blockchain chain(Block({make_transaction("", "alice", 10)}, "", 0));
+  Block block(block_txs, chain.tip().block_hash, 0);
+  ASSERT_TRUE(chain.add_block(block));
+  pool.remove_included(block.transactions());
+  EXPECT_EQ(pool.size(), 1U);
+  EXPECT_TRUE(pool.contains(low.txid));
+}
+
+TEST(MempoolTest, EvictsLowestFeeWhenFull) {
+  Mempool pool(3);
+  std::vector<Transaction> txs;
+  for (uint64_t i = 0; i < 5; ++i) {
+    txs.push_back(make_transaction("alice", "bob", i + 1));
+  }
+  ASSERT_TRUE(pool.add(txs[0], 2));
+  ASSERT_TRUE(pool.add(txs[1], 100));
+  ASSERT_TRUE(pool.add(txs[2], 1000));
+  EXPECT_FALSE(pool.add(txs[3], 3));
+  EXPECT_TRUE(pool.add(txs[4], 500));
+  EXPECT_EQ(pool.size(), 3U);
+  EXPECT_EQ(pool.evictions(), 1U);
+  EXPECT_FALSE(pool.contains(txs[0].txid));
+  EXPECT_TRUE(pool.remove(txs[1].txid));
+  EXPECT_FALSE(pool.remove(txs[1].txid));
+  EXPECT_EQ(pool.build_template(10).size(), 2U);
+}
\ No newline at end of file
@@ -0,0 +1,148 @@
+#include "benchmark_modes.h"
+#include <Timer.h>
+#include <algorithm>
+#include <crypto/chunk_store.h>
+#include <crypto/hasher_registry.h>
+#include <thread_pool.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::uint64_t next_random(std::uint64_t &state) {
+  state ^= state << 13U;
+  state ^= state >> 7U;
+  state ^= state << 17U;
+  return state;
+}
+
+std::string snapshot_data(std::size_t size, std::uint64_t seed) {
+  std::string data(size, '\0');
+  std::uint64_t state = seed;
+  for (std::size_t at = 0; at < size; at += 8) {
+    const std::uint64_t word = next_random(state);
+    std::memcpy(data.data() + at, &word, std::min<std::size_t>(8, size - at));
+  }
+  return data;
+}
+
+// The next snapshot of a dataset: a few scattered inserts, deletes and
+// overwrites, so most content survives but shifted.
+std::string edit_snapshot(std::string data, std::size_t edits) {
+  std::uint64_t state = 0x9E3779B97F4A7C15ULL;
+  for (std::size_t e = 0; e < edits && data.size() > 64; ++e) {
+    const std::size_t at = next_random(state) % (data.size() - 64);
+    switch (e % 3) {
+    case 0:
+      data.insert(at, snapshot_data(16, state));
+      break;
+    case 1:
+      data.erase(at, 16);
+      break;
+    default:
+      data.replace(at, 32, snapshot_data(32, state));
+      break;
+    }
+  }
+  return data;
+}
+
+void row(const std::string &stage, std::size_t bytes, double seconds,
+         const PutStats *stats = nullptr) {
+  std::cout << std::fixed << std::setprecision(0) << "| " << stage << " | "
+            << static_cast<double>(bytes) / 1e6 / seconds << " | ";
+  if (stats) {
+    std::cout << stats->new_chunks << " / " << stats->chunks << " | "
+              << std::setprecision(1)
+              << static_cast<double>(stats->new_bytes) / (1 << 20U);
+  } else {
+    std::cout << "- | -";
+  }
+  std::cout << " |\n";
+}
+
+} // namespace
+
+int benchmark_chunk_store(int argc, char *argv[]) {
+  const std::size_t mib =
+      argc > 2 ? static_cast<std::size_t>(std::stoull(argv[2])) : 256U;
+  const std::string hasher_name = argc > 3 ? argv[3] : "ai";
+  const std::size_t size = mib << 20U;
+
+  const std::string first = snapshot_data(size, 0x243F6A8885A308D3ULL);
+  const std::string second = edit_snapshot(first, 64);
+  const std::filesystem::path root =
+      std::filesystem::temp_directory_path() / "hashf_cdc_benchmark";
+  std::filesystem::remove_all(root);
+
+  std::cout << mib << " MiB snapshots, " << hasher_name << " digests, "
+            << ThreadPool::global().size() << " threads\n\n";
+  std::cout << "| Stage | MB/s | New chunks | New MiB |\n";
+  std::cout << "| :---- | ---: | ---------: | ------: |\n";
+
+  std::string copy(size, '\0');
+  Timer t;
+  std::memcpy(copy.data(), first.data(), size);
+  row("memcpy (bandwidth reference)", size, t.elapsed());
+
+  int exit_code = 0;
+  try {
+    ChunkStore store(root, hasher_name);
+
+    t.reset();
+    const std::vector<std::size_t> lengths = store.chunker().split(first);
+    row("Gear chunking", size, t.elapsed());
+
+    const auto hasher = HasherRegistry::make(hasher_name);
+    std::vector<std::size_t> offsets(lengths.size());
+    for (std::size_t i = 1; i < lengths.size(); ++i) {
+      offsets[i] = offsets[i - 1] + lengths[i - 1];
+    }
+    std::vector<std::string> digests(lengths.size());
+    t.reset();
+    ThreadPool::global().parallel_for(
+        lengths.size(), 8, [&](std::size_t begin, std::size_t end) {
+          for (std::size_t i = begin; i < end; ++i) {
+            digests[i] = hasher->hash256bit(first.substr(offsets[i], lengths[i]));
+          }
+        });
+    row("chunk hashing", size, t.elapsed());
+
+    PutStats stats;
+    t.reset();
+    store.put(first, &stats);
+    row("put snapshot 1", size, t.elapsed(), &stats);
+
+    t.reset();
+    const Manifest edited = store.put(second, &stats);
+    row("put snapshot 2 (64 edits)", second.size(), t.elapsed(), &stats);
+
+    std::istringstream stream(first);
+    t.reset();
+    store.put(stream, &stats);
+    row("put snapshot 1 again (stream)", size, t.elapsed(), &stats);
+
+    std::ostringstream restored;
+    t.reset();
+    store.restore(edited, restored);
+    row("restore snapshot 2", second.size(), t.elapsed());
+    if (restored.str() != second) {
+      std::cerr << "restored snapshot does not match\n";
+      exit_code = 1;
+    }
+    std::cout << "\nchunks: " << lengths.size() << ", average "
+              << size / std::max<std::size_t>(1, lengths.size()) << " bytes\n";
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << '\n';
+    exit_code = 1;
+  }
+  std::filesystem::remove_all(root);
+  return exit_code;
+}
\ No newline at end of file
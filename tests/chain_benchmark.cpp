@@ -0,0 +1,160 @@
+#include "benchmark_modes.h"
+#include <Timer.h>
+#include <crypto/blockchain.h>
+#include <crypto/mempool.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+Blockchain build_chain(std::size_t length) {
+  const std::vector<Transaction> reward = {make_transaction("", "miner", 50)};
+  Blockchain chain(Block(reward, "", 0));
+  for (std::size_t h = 1; h < length; ++h) {
+    chain.add_block(Block(reward, chain.tip().block_hash, 0));
+  }
+  return chain;
+}
+
+std::vector<unsigned> thread_sweep() {
+  const unsigned max_threads =
+      std::max(1u, std::thread::hardware_concurrency());
+  std::vector<unsigned> thread_counts;
+  for (unsigned t = 1; t < max_threads; t *= 2) {
+    thread_counts.push_back(t);
+  }
+  thread_counts.push_back(max_threads);
+  return thread_counts;
+}
+
+} // namespace
+
+int benchmark_chain_validation(int argc, char *argv[]) {
+  const std::size_t length =
+      argc > 2 ? static_cast<std::size_t>(std::stoull(argv[2])) : 1'000'000U;
+
+  std::cout << "building chain of " << length << " blocks..\n";
+  Timer build_timer;
+  const Blockchain chain = build_chain(length);
+  std::cout << "built in " << build_timer.elapsed() << " s\n\n";
+
+  std::cout << "| Threads | Time (s) | Blocks/s | Speedup |\n";
+  std::cout << "| ------: | -------: | -------: | ------: |\n";
+  double single_thread = 0.0;
+  for (unsigned threads : thread_sweep()) {
+    Timer t;
+    const ValidationResult result = chain.validate({}, threads);
+    const double elapsed = t.elapsed();
+    if (!result.valid) {
+      std::cerr << "chain unexpectedly invalid at height "
+                << *result.first_invalid_height << ": " << result.reason
+                << '\n';
+      return 1;
+    }
+    if (threads == 1) {
+      single_thread = elapsed;
+    }
+    std::cout << std::fixed << std::setprecision(4) << "| " << threads
+              << " | " << elapsed << " | "
+              << std::setprecision(0) << static_cast<double>(length) / elapsed
+              << " | " << std::setprecision(2) << single_thread / elapsed
+              << " |\n";
+  }
+  return 0;
+}
+
+int benchmark_transaction_verification(int argc, char *argv[]) {
+  const std::size_t count =
+      argc > 2 ? static_cast<std::size_t>(std::stoull(argv[2])) : 100'000U;
+
+  std::cout << "building block of " << count << " transactions..\n";
+  std::vector<Transaction> txs;
+  txs.reserve(count);
+  txs.push_back(make_transaction("", "bank", count * 100U));
+  for (std::size_t i = 1; i < count; ++i) {
+    txs.push_back(make_transaction("bank", "user" + std::to_string(i % 4096),
+                                   i % 97U + 1U));
+  }
+
+  std::cout << "| Threads | Txid (s) | Conflicts (s) | Balances (s) | Total (s) |\n";
+  std::cout << "| ------: | -------: | ------------: | -----------: | --------: |\n";
+  for (unsigned threads : thread_sweep()) {
+    BalanceIndex balances;
+    const VerificationResult result =
+        TransactionVerifier(threads).verify(txs, balances);
+    if (!result.valid) {
+      std::cerr << "block unexpectedly invalid at " << *result.first_invalid_index
+                << ": " << result.reason << '\n';
+      return 1;
+    }
+    const VerificationTimings &t = result.timings;
+    std::cout << std::fixed << std::setprecision(4) << "| " << threads << " | "
+              << t.txid_seconds << " | " << t.conflict_seconds << " | "
+              << t.balance_seconds << " | " << t.total() << " |\n";
+  }
+  return 0;
+}
+
+int benchmark_mempool(int argc, char *argv[]) {
+  const std::size_t count =
+      argc > 2 ? static_cast<std::size_t>(std::stoull(argv[2])) : 1'000'000U;
+  const std::size_t template_size = 10'000;
+
+  std::vector<Transaction> txs;
+  std::vector<std::uint64_t> fees;
+  txs.reserve(count);
+  fees.reserve(count);
+  std::uint64_t state = 0x9e3779b97f4a7c15ULL;
+  for (std::size_t i = 0; i < count; ++i) {
+    state ^= state << 13U;
+    state ^= state >> 7U;
+    state ^= state << 17U;
+    txs.push_back(Transaction{"tx" + std::to_string(i),
+                              "user" + std::to_string(i % 4096), "shop",
+                              i % 1000U + 1U});
+    fees.push_back(state >> (state & 63U));
+  }
+
+  Mempool pool(count);
+  Timer t;
+  for (std::size_t i = 0; i < count; ++i) {
+    pool.add(txs[i], fees[i]);
+  }
+  const double add_time = t.elapsed();
+
+  t.reset();
+  const auto block_txs = pool.build_template(template_size);
+  const double template_time = t.elapsed();
+
+  t.reset();
+  pool.remove_included(block_txs);
+  const double remove_time = t.elapsed();
+
+  Mempool bounded(count / 4U);
+  t.reset();
+  for (std::size_t i = 0; i < count; ++i) {
+    bounded.add(txs[i], fees[i]);
+  }
+  const double bounded_time = t.elapsed();
+
+  std::cout << std::fixed << std::setprecision(4);
+  std::cout << "| Operation | Count | Time (s) | ns/op |\n";
+  std::cout << "| --------- | ----: | -------: | ----: |\n";
+  auto row = [](const char *name, std::size_t n, double seconds) {
+    std::cout << "| " << name << " | " << n << " | " << seconds << " | "
+              << std::setprecision(1) << seconds * 1e9 / static_cast<double>(n)
+              << std::setprecision(4) << " |\n";
+  };
+  row("add", count, add_time);
+  row("build_template", block_txs.size(), template_time);
+  row("remove_included", block_txs.size(), remove_time);
+  row("add (bounded, evicting)", count, bounded_time);
+  std::cout << "evictions: " << bounded.evictions() << '\n';
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,137 @@
+#include "benchmark_modes.h"
+#include <constants.h>
+#include <crypto/digest_bytes.h>
+#include <crypto/hasher_registry.h>
+#include <digest_runs.h>
+#include <hex.h>
+#include <Timer.h>
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread_pool.h>
+
+namespace {
+
+constexpr std::size_t kShownDuplicates = 10;
+
+// Input i is its decimal form, so a source index is enough to report it.
+std::string input_for(std::uint64_t source) { return std::to_string(source); }
+
+double mb_per_s(std::uint64_t bytes, double seconds) {
+  return seconds > 0.0 ? static_cast<double>(bytes) / seconds * 1e-6 : 0.0;
+}
+
+// Removes the run files DigestRunWriter left in dir, however the benchmark
+// ends; a failed write leaves runs that finish() never reported.
+struct RunCleanup {
+  std::filesystem::path dir;
+  ~RunCleanup() {
+    std::error_code error;
+    for (const auto &entry : std::filesystem::directory_iterator(dir, error)) {
+      const std::string name = entry.path().filename().string();
+      if (name.starts_with("run_") && name.ends_with(".bin")) {
+        std::filesystem::remove(entry.path(), error);
+      }
+    }
+  }
+};
+
+} // namespace
+
+// Every duplicate digest among the first N inputs, through sorted runs on
+// disk. Optional arguments: input count (default 2^22), records per run
+// (default 2^20, 40 MiB per buffer), hasher name (default ai) and run
+// directory.
+int benchmark_external(int argc, char *argv[]) {
+  std::uint64_t count = std::uint64_t{1} << 22U;
+  std::size_t run_records = std::size_t{1} << 20U;
+  try {
+    if (argc > 2) {
+      count = std::stoull(argv[2]);
+    }
+    if (argc > 3) {
+      run_records = std::stoull(argv[3]);
+    }
+  } catch (const std::exception &e) {
+    std::cerr << "bad argument: " << e.what() << '\n';
+    return 1;
+  }
+  const std::string hasher_name = argc > 4 ? argv[4] : "ai";
+  const std::filesystem::path dir = argc > 5 ? argv[5] : kResultsPath / "runs";
+
+  std::cout << count << " inputs, " << run_records << " records per run, hasher "
+            << hasher_name << ", runs in " << dir << "\n\n";
+  const RunCleanup cleanup{dir};
+  try {
+    const std::filesystem::path report_path = kResultsPath / "external_collisions.txt";
+    std::filesystem::create_directories(report_path.parent_path());
+    std::ofstream report(report_path, std::ios::trunc);
+    if (!report) {
+      throw std::runtime_error("failed to open '" + report_path.string() + "'");
+    }
+
+    std::vector<std::filesystem::path> runs;
+    Timer write_timer;
+    HasherRegistry::visit(hasher_name, [&](const auto &hasher) {
+      DigestRunWriter writer(dir, run_records);
+      for (std::uint64_t next = 0; next < count;) {
+        const std::size_t take =
+            static_cast<std::size_t>(std::min<std::uint64_t>(writer.free_records(), count - next));
+        const std::span<DigestRecord> records = writer.append(take);
+        ThreadPool::global().parallel_for(take, 256, [&](std::size_t begin, std::size_t end) {
+          for (std::size_t i = begin; i < end; ++i) {
+            records[i].source = next + i;
+            records[i].digest = digest_bytes<32>(hasher, input_for(next + i));
+          }
+        });
+        next += take;
+        if (writer.free_records() == 0) {
+          writer.flush();
+        }
+      }
+      runs = writer.finish();
+    });
+    const double write_seconds = write_timer.elapsed();
+    const std::uint64_t bytes = count * sizeof(DigestRecord);
+    std::cout << "hash, sort and write: " << write_seconds << " s, " << runs.size()
+              << " run(s), " << mb_per_s(bytes, write_seconds) << " MB/s\n";
+
+    std::size_t shown = 0;
+    Timer merge_timer;
+    const MergeStats stats = merge_runs(runs, [&](const DuplicateDigest &duplicate) {
+      const std::string digest = hex_encode(duplicate.digest);
+      report << digest;
+      for (const std::uint64_t source : duplicate.sources) {
+        report << ' ' << input_for(source);
+      }
+      report << '\n';
+      if (shown++ < kShownDuplicates) {
+        std::cout << digest << ':';
+        for (const std::uint64_t source : duplicate.sources) {
+          std::cout << " \"" << input_for(source) << '"';
+        }
+        std::cout << '\n';
+      }
+    });
+    const double merge_seconds = merge_timer.elapsed();
+    if (!report.flush()) {
+      throw std::runtime_error("failed to write '" + report_path.string() + "'");
+    }
+    std::cout << "merge: " << merge_seconds << " s, " << mb_per_s(stats.bytes, merge_seconds)
+              << " MB/s\n\n";
+    std::cout << "| Records | Run bytes | Duplicate digests | Records in them |\n"
+              << "| ------: | --------: | ----------------: | --------------: |\n"
+              << "| " << stats.records << " | " << stats.bytes << " | "
+              << stats.duplicate_digests << " | " << stats.duplicate_records << " |\n";
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << '\n';
+    return 1;
+  }
+  return 0;
+}
\ No newline at end of file
@@ -1,39 +1,40 @@
 #include "AIHasher.h"
 #include "FileRead.h"
+#include <bench_results.h>
+#include <async_file_reader.h>
+#include <digest_cache.h>
+#include <digest_runs.h>
+#include <crypto/AIHasher64.h>
+#include <crypto/AITreeHasher.h>
+#include <crypto/chunk_store.h>
+#include <crypto/chunker.h>
+#include <crypto/flat_string_map.h>
+#include <crypto/hasher_registry.h>
+#include <crypto/sha256_hasher.h>
 #include <Hasher.h>
 #include <constants.h>
+#include <hex.h>
+#include <latency_histogram.h>
+#include <perf_counters.h>
+#include <rho_collision.h>
+#include <sac_analyzer.h>
+#include <stage_profiler.h>
+#include <thread_pool.h>
+#include <utils.h>
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <cctype>
+#include <cmath>
 #include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
 #include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
 #include <gtest/gtest.h>
 
-namespace {
-
-int bit_diff_hex(const std::string &hash1, const std::string &hash2) {
-  static constexpr std::array<int, 16> kPopcount4 = {
-      0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
-  constexpr auto hex_val = [](char c) -> int {
-    if (c >= '0' && c <= '9')
-      return c - '0';
-    if (c >= 'a' && c <= 'f')
-      return 10 + (c - 'a');
-    if (c >= 'A' && c <= 'F')
-      return 10 + (c - 'A');
-    throw std::invalid_argument("invalid hex character");
-  };
-
-  const std::size_t max_len = std::max(hash1.size(), hash2.size());
-  int diff = 0;
-  for (std::size_t i = 0; i < max_len; ++i) {
-    const int v1 = i < hash1.size() ? hex_val(hash1[i]) : 0;
-    const int v2 = i < hash2.size() ? hex_val(hash2[i]) : 0;
-    diff += kPopcount4[static_cast<std::size_t>((v1 ^ v2) & 0x0F)];
-  }
-  return diff;
-}
-
-} // namespace
 AIHasher hasher;
 static std::optional<std::string>
 read_file_safe(const std::filesystem::path &p) {
@@ -103,7 +104,7 @@ TEST(HashTest, AvalancheSingleCharacter) {
   const auto hash1 = hasher.hash256bit(base);
   base[4321] = 'b';
   const auto hash2 = hasher.hash256bit(base);
-  const int diff = bit_diff_hex(hash1, hash2);
+  const int diff = bit_diff(hash1, hash2);
   EXPECT_GT(diff, 120) << "Expected strong avalanche for long input";
 }
 
@@ -118,7 +119,7 @@ TEST(HashTest, AvalancheBitFlipsAcrossMessage) {
     std::string mutated = base;
     mutated[i] = static_cast<char>(mutated[i] ^ 0x01);
     const auto mutated_hash = hasher.hash256bit(mutated);
-    const int diff = bit_diff_hex(original, mutated_hash);
+    const int diff = bit_diff(original, mutated_hash);
     EXPECT_GT(diff, 64) << "Weak avalanche at position " << i;
     total_diff += diff;
     ++samples;
@@ -128,4 +129,921 @@ TEST(HashTest, AvalancheBitFlipsAcrossMessage) {
   const double average_diff = static_cast<double>(total_diff) /
                               static_cast<double>(samples);
   EXPECT_GT(average_diff, 100.0) << "Average avalanche effect too small";
+}
+
+TEST(TreeHashTest, ThreadCountDoesNotChangeDigest) {
+  std::string input;
+  for (int i = 0; i < 300000; ++i) {
+    input.push_back(static_cast<char>((i * 131) ^ (i >> 7)));
+  }
+  const auto single = AITreeHasher(1).hash256bit(input);
+  EXPECT_EQ(single.size(), 64U);
+  EXPECT_EQ(single, AITreeHasher(3).hash256bit(input));
+  EXPECT_EQ(single, AITreeHasher(8).hash256bit(input));
+  EXPECT_NE(single, hasher.hash256bit(input));
+}
+
+TEST(HashTest, ThreadCountDoesNotChangeDigest) {
+  std::string input;
+  for (int i = 0; i < 100000; ++i) {
+    input.push_back(static_cast<char>((i * 131) ^ (i >> 7)));
+  }
+  const auto whole_pool = hasher.hash256bit(input);
+  EXPECT_EQ(whole_pool, AIHasher(1).hash256bit(input));
+  EXPECT_EQ(whole_pool, AIHasher(3).hash256bit(input));
+  EXPECT_EQ(AIHasher("key").hash256bit(input), AIHasher("key", 2).hash256bit(input));
+}
+
+TEST(TreeHashTest, StreamMatchesOneShot) {
+  const AITreeHasher tree(2);
+  for (std::size_t size : {std::size_t{0}, std::size_t{1}, AITreeHasher::kLeafSize,
+                           AITreeHasher::kLeafSize + 1, AITreeHasher::kLeafSize * 7,
+                           AITreeHasher::kLeafSize * 9 + 123}) {
+    const std::string input(size, 'q');
+    AITreeHasher::Stream stream;
+    for (std::size_t pos = 0; pos < size; pos += 5000) {
+      stream.update(std::string_view(input).substr(pos, 5000));
+    }
+    EXPECT_EQ(stream.finalize(), tree.digest(input)) << "size " << size;
+  }
+}
+
+TEST(TreeHashTest, IncrementalUpdateMatchesRehash) {
+  std::string input(AITreeHasher::kLeafSize * 11 + 77, 'a');
+  AITreeHasher::Incremental tree(input, 2);
+  EXPECT_EQ(tree.root(), AITreeHasher(1).digest(input));
+
+  input[AITreeHasher::kLeafSize * 3 + 5] = 'b';
+  input.replace(AITreeHasher::kLeafSize * 10 - 2, 4, "wxyz");
+  tree.update(input, AITreeHasher::kLeafSize * 3 + 5, 1);
+  tree.update(input, AITreeHasher::kLeafSize * 10 - 2, 4);
+  EXPECT_EQ(tree.root(), AITreeHasher(1).digest(input));
+  EXPECT_THROW(tree.update(input + "x", 0, 1), std::invalid_argument);
+}
+
+TEST(ThreadPoolTest, NestedParallelForCompletes) {
+  ThreadPool pool(2);
+  std::atomic<std::size_t> visited{0};
+  pool.parallel_for(8, 1, [&](std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+      pool.parallel_for(1000, 10, [&](std::size_t b, std::size_t e) {
+        visited.fetch_add(e - b);
+      });
+    }
+  });
+  EXPECT_EQ(visited.load(), 8000U);
+}
+
+TEST(ThreadPoolTest, TaskGroupRethrowsFirstError) {
+  ThreadPool pool(2);
+  TaskGroup group(pool);
+  group.run([]() { throw std::runtime_error("boom"); });
+  group.run([]() {});
+  EXPECT_THROW(group.wait(), std::runtime_error);
+}
+
+TEST(ThreadPoolTest, CountsOnlyTasksRunByWorkers) {
+  ThreadPool pool(2);
+  pool.parallel_for(1, 1, [](std::size_t, std::size_t) {});
+  EXPECT_EQ(pool.worker_tasks(), 0U);
+  // A future does not help, so a worker must run the task.
+  pool.submit([]() {}).get();
+  EXPECT_EQ(pool.worker_tasks(), 1U);
+}
+
+TEST(ThreadPoolTest, ParallelHashMatchesAcrossBatch) {
+  const AIHasher hasher;
+  const std::vector<std::string> inputs(16, std::string(64 * 1024, 'z'));
+  std::vector<std::string> digests(inputs.size());
+  ThreadPool::global().parallel_for(inputs.size(), 1,
+                                    [&](std::size_t begin, std::size_t end) {
+                                      for (std::size_t i = begin; i < end; ++i) {
+                                        digests[i] = hasher.hash256bit(inputs[i]);
+                                      }
+                                    });
+  EXPECT_EQ(std::count(digests.begin(), digests.end(), digests.front()),
+            static_cast<std::ptrdiff_t>(digests.size()));
+  EXPECT_EQ(digests.front(), hasher.hash256bit(inputs.front()));
+}
+
+TEST(ThreadPoolTest, PooledLegacyHasherMatchesSequential) {
+  const Hasher legacy;
+  ThreadPool pool(4);
+  std::vector<std::string> inputs(2000);
+  for (std::size_t i = 0; i < inputs.size(); ++i) {
+    inputs[i] = std::to_string(i * 7919);
+  }
+  std::vector<std::string> pooled(inputs.size());
+  pool.parallel_for(inputs.size(), 1, [&](std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+      pooled[i] = legacy.hash256bit(inputs[i]);
+    }
+  });
+  for (std::size_t i = 0; i < inputs.size(); ++i) {
+    EXPECT_EQ(pooled[i], legacy.hash256bit(inputs[i])) << inputs[i];
+  }
+}
+
+TEST(Sha256Test, MatchesKnownVectorsAcrossEntryPoints) {
+  const SHA256_Hasher hasher;
+  const std::string abc_hex =
+      "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad";
+  EXPECT_EQ(hasher.hash256bit("abc"), abc_hex);
+  EXPECT_EQ(hasher.hash256bit(""),
+            "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+  const SHA256_Hasher::Digest raw = hasher.digest("abc");
+  EXPECT_EQ(raw[0], 0xbaU);
+  EXPECT_EQ(raw[31], 0xadU);
+
+  const std::vector<std::string> inputs = {"abc", "", "abc"};
+  const auto batch = hasher.hash256bit_batch(inputs);
+  ASSERT_EQ(batch.size(), inputs.size());
+  EXPECT_EQ(batch[0], abc_hex);
+  EXPECT_EQ(batch[1], hasher.hash256bit(""));
+  EXPECT_EQ(batch[2], abc_hex);
+}
+
+TEST(KeyedHashTest, HmacSha256MatchesRfc4231) {
+  const SHA256_Hasher hmac("Jefe");
+  EXPECT_EQ(hmac.hash256bit("what do ya want for nothing?"),
+            "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843");
+  const std::string long_key(131, '\xaa');
+  EXPECT_EQ(SHA256_Hasher(long_key).hash256bit(
+                "Test Using Larger Than Block-Size Key - Hash Key First"),
+            "60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54");
+  EXPECT_EQ(SHA256_Hasher().keyed("Jefe")->hash256bit("abc"),
+            hmac.hash256bit("abc"));
+}
+
+TEST(KeyedHashTest, KeyChangesEveryHasher) {
+  const std::string input(5000, 'k');
+  const std::array<std::pair<const char *, std::unique_ptr<IHasher>>, 3> hashers = {{
+      {"ai", std::make_unique<AIHasher>()},
+      {"legacy", std::make_unique<Hasher>()},
+      {"tree", std::make_unique<AITreeHasher>(2)},
+  }};
+  for (const auto &[name, plain] : hashers) {
+    const auto salted = plain->keyed("salt");
+    EXPECT_EQ(salted->hash256bit(input), plain->keyed("salt")->hash256bit(input))
+        << name;
+    EXPECT_NE(salted->hash256bit(input), plain->hash256bit(input)) << name;
+    EXPECT_NE(salted->hash256bit(input), plain->keyed("salu")->hash256bit(input))
+        << name;
+    EXPECT_NE(plain->keyed("")->hash256bit(input), plain->hash256bit(input)) << name;
+  }
+}
+
+TEST(HasherRegistryTest, VisitAndMakeAgree) {
+  const std::string input = "lietuva";
+  for (const std::string_view name : HasherRegistry::names()) {
+    std::string concrete;
+    HasherRegistry::visit(name, [&](const auto &hasher) {
+      concrete = hasher.hash256bit(input);
+    });
+    EXPECT_EQ(HasherRegistry::make(name)->hash256bit(input), concrete) << name;
+  }
+  std::string ai;
+  HasherRegistry::visit("ai", [&](const auto &hasher) {
+    ai = hasher.hash256bit(input);
+  });
+  EXPECT_EQ(ai, AIHasher().hash256bit(input));
+  EXPECT_THROW(HasherRegistry::make("md5"), std::invalid_argument);
+}
+
+TEST(HexTest, EveryCodecMatchesScalar) {
+  const auto codecs = hex_codecs();
+  ASSERT_EQ(std::string(codecs.front().name), "scalar");
+  std::vector<std::uint8_t> bytes(300);
+  for (std::size_t i = 0; i < bytes.size(); ++i) {
+    bytes[i] = static_cast<std::uint8_t>(i * 151 + 7);
+  }
+  for (std::size_t size : {0, 1, 15, 16, 17, 31, 32, 33, 64, 100, 300}) {
+    std::string expected(size * 2, '\0');
+    codecs.front().encode(bytes.data(), size, expected.data());
+    std::string upper = expected;
+    std::transform(upper.begin(), upper.end(), upper.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+    for (const HexCodec &codec : codecs) {
+      std::string encoded(size * 2, '\0');
+      codec.encode(bytes.data(), size, encoded.data());
+      EXPECT_EQ(encoded, expected) << codec.name << ' ' << size;
+      std::vector<std::uint8_t> decoded(size);
+      EXPECT_EQ(codec.decode(upper.data(), size, decoded.data()), kHexValid)
+          << codec.name << ' ' << size;
+      EXPECT_TRUE(std::equal(decoded.begin(), decoded.end(), bytes.begin()))
+          << codec.name << ' ' << size;
+    }
+  }
+}
+
+TEST(HexTest, DecodeReportsFirstBadCharacter) {
+  const std::string valid = hex_encode(std::vector<std::uint8_t>(50, 0xA7));
+  std::vector<std::uint8_t> out(valid.size() / 2);
+  for (std::size_t at = 0; at < valid.size(); at += 7) {
+    for (const char bad : {'g', 'G', '/', ':', '@', '`', ' ', '\x80'}) {
+      std::string input = valid;
+      input[at] = bad;
+      for (const HexCodec &codec : hex_codecs()) {
+        EXPECT_EQ(codec.decode(input.data(), out.size(), out.data()), at)
+            << codec.name << ' ' << at << ' ' << bad;
+      }
+    }
+  }
+  std::size_t offset = 0;
+  EXPECT_FALSE(hex_decode("abc", out.data(), &offset));
+  EXPECT_EQ(offset, 3U);
+  EXPECT_THROW((void)hex_decode("0x12"), std::invalid_argument);
+  EXPECT_EQ(hex_decode("00fF7a"), (std::vector<std::uint8_t>{0x00, 0xFF, 0x7A}));
+  EXPECT_THROW(hex_to_ascii("zz"), std::invalid_argument);
+}
+
+TEST(HexTest, DiffCountsIgnoreCaseAndCountUnmatchedDigits) {
+  const std::string a(64, 'f');
+  std::string b = a;
+  b[0] = '0';
+  b[63] = 'e';
+  EXPECT_EQ(bit_diff(a, b), 5);
+  EXPECT_EQ(hex_diff(a, b), 2);
+  EXPECT_EQ(hex_diff("ABcd", "abCD"), 0);
+  EXPECT_EQ(bit_diff("ab", "abc"), 2);
+  EXPECT_EQ(hex_diff("ab", "ab0"), 1);
+  EXPECT_THROW(bit_diff(a, std::string(63, 'f') + "x"), std::invalid_argument);
+  EXPECT_THROW(hex_diff("q", "0"), std::invalid_argument);
+}
+
+namespace {
+
+std::string pseudo_random(std::size_t size, std::uint32_t seed) {
+  std::string data(size, '\0');
+  for (auto &c : data) {
+    seed = seed * 1664525U + 1013904223U;
+    c = static_cast<char>(seed >> 24U);
+  }
+  return data;
+}
+
+} // namespace
+
+TEST(ChunkerTest, BoundariesRespectLimitsAndSurviveInsertions) {
+  const Chunker chunker({256, 1024, 4096});
+  const std::string data = pseudo_random(200000, 7);
+  const std::vector<std::size_t> lengths = chunker.split(data);
+  std::size_t total = 0;
+  for (std::size_t i = 0; i < lengths.size(); ++i) {
+    total += lengths[i];
+    EXPECT_LE(lengths[i], 4096U);
+    if (i + 1 < lengths.size()) {
+      EXPECT_GE(lengths[i], 256U);
+    }
+  }
+  EXPECT_EQ(total, data.size());
+  EXPECT_GT(lengths.size(), 100U);
+
+  // Cut points after an insertion shift by its length; nearly all survive.
+  auto boundaries = [&](const std::string &input) {
+    std::unordered_set<std::size_t> ends;
+    std::size_t at = 0;
+    for (std::size_t length : chunker.split(input)) {
+      ends.insert(at += length);
+    }
+    return ends;
+  };
+  const auto before = boundaries(data);
+  const auto after = boundaries(data.substr(0, 5000) + "inserted" + data.substr(5000));
+  std::size_t kept = 0;
+  for (std::size_t end : before) {
+    kept += end > 5000 && after.contains(end + 8);
+  }
+  EXPECT_GE(kept + 10, before.size());
+  EXPECT_THROW(Chunker({0, 1024, 4096}), std::invalid_argument);
+  EXPECT_THROW(Chunker({256, 1000, 4096}), std::invalid_argument);
+}
+
+TEST(ChunkStoreTest, StoresRepeatedSnapshotsOnce) {
+  const auto root = std::filesystem::temp_directory_path() / "hashf_chunk_store_test";
+  std::filesystem::remove_all(root);
+  const std::string snapshot = pseudo_random(300000, 11);
+  std::string edited = snapshot;
+  edited.insert(150000, "a small edit");
+  {
+    ChunkStore store(root, "ai", {256, 1024, 4096});
+    PutStats first;
+    const Manifest original = store.put(snapshot, &first);
+    EXPECT_EQ(first.new_chunks, first.chunks);
+    EXPECT_EQ(original.size, snapshot.size());
+
+    PutStats second;
+    std::istringstream stream(edited);
+    const Manifest changed = store.put(stream, &second);
+    EXPECT_LE(second.new_chunks, 3U);
+    EXPECT_EQ(changed.size, edited.size());
+
+    std::ostringstream restored;
+    store.restore(changed, restored);
+    EXPECT_EQ(restored.str(), edited);
+  }
+  {
+    ChunkStore reopened(root, "ai", {256, 1024, 4096});
+    PutStats again;
+    reopened.put(snapshot, &again);
+    EXPECT_EQ(again.new_chunks, 0U);
+    EXPECT_THROW(ChunkStore(root, "sha256"), std::invalid_argument);
+
+    const Manifest manifest = reopened.put(std::string_view(snapshot).substr(0, 2000));
+    const ChunkRef &chunk = manifest.chunks.front();
+    std::ofstream(root / "objects" / chunk.digest.substr(0, 2) / chunk.digest.substr(2),
+                  std::ios::binary | std::ios::trunc)
+        << "tampered";
+    std::ostringstream out;
+    EXPECT_THROW(reopened.restore(manifest, out), std::runtime_error);
+  }
+  std::filesystem::remove_all(root);
+}
+
+TEST(ChunkStoreTest, FailedWriteLeavesNoPhantomChunks) {
+  const auto root = std::filesystem::temp_directory_path() / "hashf_chunk_store_fail_test";
+  std::filesystem::remove_all(root);
+  const std::string data = pseudo_random(100000, 23);
+  {
+    ChunkStore store(root, "ai", {256, 1024, 4096});
+    // A plain file where the objects directory should be makes every write
+    // fail; running as root, a read-only directory would not.
+    std::filesystem::remove_all(root / "objects");
+    std::ofstream(root / "objects") << "in the way";
+    EXPECT_ANY_THROW(store.put(data));
+    EXPECT_EQ(store.chunk_count(), 0U);
+
+    std::filesystem::remove(root / "objects");
+    std::filesystem::create_directories(root / "objects");
+    PutStats stats;
+    const Manifest manifest = store.put(data, &stats);
+    EXPECT_EQ(stats.new_chunks, stats.chunks);
+    std::ostringstream restored;
+    store.restore(manifest, restored);
+    EXPECT_EQ(restored.str(), data);
+  }
+  std::filesystem::remove_all(root);
+}
+
+TEST(ChunkStoreTest, LegacyHasherChunksMatchTheirNames) {
+  const auto root = std::filesystem::temp_directory_path() / "hashf_chunk_store_legacy_test";
+  std::filesystem::remove_all(root);
+  const std::string data = pseudo_random(200000, 5);
+  {
+    ChunkStore store(root, "asmeninis", {256, 1024, 4096});
+    const Manifest manifest = store.put(data);
+    ASSERT_GT(manifest.chunks.size(), 10U);
+    const Hasher legacy;
+    std::size_t at = 0;
+    for (const ChunkRef &chunk : manifest.chunks) {
+      EXPECT_EQ(chunk.digest, legacy.hash256bit(data.substr(at, chunk.size)));
+      at += chunk.size;
+    }
+    std::ostringstream restored;
+    store.restore(manifest, restored);
+    EXPECT_EQ(restored.str(), data);
+  }
+  std::filesystem::remove_all(root);
+}
+
+TEST(AsyncFileReaderTest, BothBackendsDeliverEveryFile) {
+  const auto dir = std::filesystem::temp_directory_path() / "hashf_async_reader_test";
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  std::vector<std::filesystem::path> files;
+  std::vector<std::string> contents;
+  for (std::size_t size : {0, 1, 100, 4096, 4097, 20000, 3000, 7}) {
+    contents.push_back(pseudo_random(size, static_cast<std::uint32_t>(size)));
+    files.push_back(dir / std::to_string(files.size()));
+    std::ofstream(files.back(), std::ios::binary) << contents.back();
+  }
+
+  for (const bool force_pread : {false, true}) {
+    AsyncFileReader reader({3, 4096, force_pread});
+    std::vector<std::string> seen(files.size());
+    std::atomic<int> calls{0};
+    reader.read_all(files, [&](std::size_t index, std::string_view data) {
+      seen[index] = std::string(data);
+      ++calls;
+    });
+    EXPECT_EQ(calls.load(), static_cast<int>(files.size())) << reader.backend();
+    EXPECT_EQ(seen, contents) << reader.backend();
+
+    std::vector<std::filesystem::path> broken = files;
+    broken.insert(broken.begin() + 2, dir / "missing");
+    EXPECT_THROW(reader.read_all(broken, [](std::size_t, std::string_view) {}),
+                 std::filesystem::filesystem_error)
+        << reader.backend();
+  }
+  std::filesystem::remove_all(dir);
+}
+
+TEST(DigestCacheTest, HitsOnlyForUnchangedIdentity) {
+  const auto dir = std::filesystem::temp_directory_path() / "hashf_digest_cache_test";
+  std::filesystem::remove_all(dir);
+  const auto path = dir / "digests";
+  constexpr std::uint64_t kAlgorithm = 7;
+  const std::int64_t old_mtime = 1'600'000'000'000'000'000;
+
+  std::vector<DigestCache::Record> records(3000);
+  for (std::size_t i = 0; i < records.size(); ++i) {
+    records[i].identity = {1, 1000 + i, i * 10, old_mtime + static_cast<std::int64_t>(i)};
+    records[i].digest.fill(static_cast<std::uint8_t>(i));
+  }
+  {
+    DigestCache cache(path);
+    EXPECT_FALSE(cache.find(records[0].identity, kAlgorithm));
+    EXPECT_EQ(cache.store(records, kAlgorithm), records.size());
+    EXPECT_EQ(cache.size(), records.size());
+    EXPECT_GE(cache.capacity(), 2 * records.size());
+  }
+
+  DigestCache reopened(path);
+  for (const auto &record : records) {
+    ASSERT_EQ(reopened.find(record.identity, kAlgorithm), record.digest);
+  }
+  EXPECT_EQ(reopened.hits(), records.size());
+  FileIdentity changed = records[5].identity;
+  changed.size += 1;
+  EXPECT_FALSE(reopened.find(changed, kAlgorithm));
+  changed = records[5].identity;
+  changed.mtime_ns += 1;
+  EXPECT_FALSE(reopened.find(changed, kAlgorithm));
+  EXPECT_FALSE(reopened.find(records[5].identity, kAlgorithm + 1));
+
+  // Updating a file replaces its entry rather than adding one.
+  DigestCache::Record update = records[5];
+  update.identity.mtime_ns += 1000;
+  update.digest.fill(0xEE);
+  EXPECT_EQ(reopened.store({&update, 1}, kAlgorithm), 1U);
+  EXPECT_EQ(reopened.find(update.identity, kAlgorithm), update.digest);
+  EXPECT_EQ(reopened.size(), records.size());
+
+  // A file written just now could change again within its mtime tick.
+  const std::filesystem::path fresh = dir / "fresh";
+  std::ofstream(fresh) << "fresh";
+  const DigestCache::Record racy{file_identity(fresh), {}};
+  EXPECT_EQ(reopened.store({&racy, 1}, kAlgorithm), 0U);
+  EXPECT_FALSE(reopened.find(racy.identity, kAlgorithm));
+
+  std::ofstream(dir / "bogus") << "not a cache";
+  EXPECT_THROW(DigestCache(dir / "bogus"), std::runtime_error);
+  std::filesystem::remove_all(dir);
+}
+
+TEST(StageProfilerTest, CountsEveryStageOfEachHash) {
+  stage_profiler::reset();
+  EXPECT_EQ(AIHasher().hash256bit("stage"), AIHasher().hash256bit("stage"));
+  Hasher().hash256bit("stage");
+  const auto totals = stage_profiler::report();
+  if (!stage_profiler::kEnabled) {
+    EXPECT_TRUE(totals.empty());
+    return;
+  }
+
+  ASSERT_EQ(totals.size(), stage_profiler::kStageCount);
+  auto calls = [&](std::string_view hasher, std::string_view stage) {
+    for (const auto &t : totals) {
+      if (t.hasher == hasher && t.stage == stage) {
+        return t.calls;
+      }
+    }
+    return std::uint64_t{0};
+  };
+  // Two AIHasher digests: premix and the squeeze each run the mixers.
+  EXPECT_EQ(calls("ai", "absorb"), 2U);
+  EXPECT_EQ(calls("ai", "mix_primary"), 2U);
+  EXPECT_EQ(calls("ai", "mix_secondary"), 4U);
+  EXPECT_EQ(calls("ai", "mix_final"), 4U);
+  EXPECT_EQ(calls("ai", "collapse"), 2U);
+  EXPECT_EQ(calls("ai", "to_hex"), 2U);
+  EXPECT_EQ(calls("asmeninis", "absorb"), 1U);
+  EXPECT_EQ(calls("asmeninis", "to_hex"), 1U);
+
+  std::ostringstream json;
+  stage_profiler::write_json(json, totals);
+  EXPECT_NE(json.str().find("\"stage\": \"mix_final\", \"calls\": 4"),
+            std::string::npos);
+}
+
+TEST(StageProfilerTest, CountsLongAbsorbOnceWhateverTheThreadCap) {
+  const std::string input = pseudo_random(4096, 17);
+  for (const unsigned cap : {1U, 0U}) {
+    stage_profiler::reset();
+    (void)AIHasher(cap).hash256bit(input);
+    const auto totals = stage_profiler::report();
+    if (!stage_profiler::kEnabled) {
+      EXPECT_TRUE(totals.empty());
+      return;
+    }
+    // A cap of 1 falls back to the sequential absorb, which must not be
+    // counted a second time by the parallel path.
+    std::uint64_t absorbs = 0;
+    for (const auto &t : totals) {
+      if (t.hasher == "ai" && t.stage == "absorb") {
+        absorbs = t.calls;
+      }
+    }
+    EXPECT_EQ(absorbs, 1U) << "thread cap " << cap;
+  }
+}
+
+TEST(LatencyHistogramTest, PercentilesStayWithinBucketPrecision) {
+  LatencyHistogram h;
+  for (std::uint64_t v = 1; v <= 100000; ++v) {
+    h.record(v);
+  }
+  EXPECT_EQ(h.count(), 100000U);
+  EXPECT_EQ(h.min(), 1U);
+  EXPECT_EQ(h.max(), 100000U);
+  EXPECT_DOUBLE_EQ(h.mean(), 50000.5);
+  for (const double q : {0.5, 0.9, 0.99, 0.999}) {
+    const double exact = q * 100000.0;
+    EXPECT_NEAR(static_cast<double>(h.percentile(q)), exact, exact / 128.0) << q;
+  }
+  EXPECT_EQ(h.percentile(1.0), 100000U);
+
+  LatencyHistogram small;
+  small.record(7, 3);
+  EXPECT_EQ(small.percentile(0.0), 7U);
+  EXPECT_EQ(small.percentile(0.999), 7U);
+  LatencyHistogram huge;
+  huge.record(~std::uint64_t{0});
+  EXPECT_EQ(huge.percentile(0.5), ~std::uint64_t{0});
+}
+
+TEST(LatencyHistogramTest, MergeMatchesRecordingIntoOne) {
+  LatencyHistogram all;
+  LatencyHistogram even;
+  LatencyHistogram odd;
+  for (std::uint64_t v = 0; v < 50000; ++v) {
+    const std::uint64_t value = (v * 2654435761U) % 1000000U;
+    all.record(value);
+    (v % 2 == 0 ? even : odd).record(value);
+  }
+  even.merge(odd);
+  EXPECT_EQ(even.count(), all.count());
+  EXPECT_EQ(even.min(), all.min());
+  EXPECT_EQ(even.max(), all.max());
+  for (const double q : {0.01, 0.5, 0.99, 0.999}) {
+    EXPECT_EQ(even.percentile(q), all.percentile(q)) << q;
+  }
+}
+
+TEST(PerfCountersTest, MissingCountersDegradeToEmptySamples) {
+  PerfCounters counters;
+  counters.start();
+  EXPECT_EQ(AIHasher().hash256bit("perf").size(), 64U);
+  const PerfSample sample = counters.stop();
+  for (std::size_t i = 0; i < kPerfEventCount; ++i) {
+    const auto event = static_cast<PerfEvent>(i);
+    EXPECT_EQ(sample[event].has_value(), counters.available(event))
+        << PerfCounters::name(event);
+  }
+  if (!counters.available()) {
+    EXPECT_FALSE(counters.reason().empty());
+    EXPECT_FALSE(sample.ipc().has_value());
+  }
+
+  PerfSample a;
+  a.values[static_cast<std::size_t>(PerfEvent::cycles)] = 400;
+  a.values[static_cast<std::size_t>(PerfEvent::instructions)] = 1000;
+  PerfSample b = a;
+  b.values[static_cast<std::size_t>(PerfEvent::llc_misses)] = 5;
+  a += b;
+  EXPECT_DOUBLE_EQ(*a.ipc(), 2.5);
+  EXPECT_DOUBLE_EQ(*a.per_byte(PerfEvent::cycles, 100), 8.0);
+  EXPECT_FALSE(a[PerfEvent::llc_misses].has_value());
+  EXPECT_FALSE(a.per_byte(PerfEvent::cycles, 0).has_value());
+}
+
+TEST(BenchResultsTest, JsonRoundTripsSamplesAndRejectsMalformedInput) {
+  BenchRun run{"abc123", {{"ai", 64, {10.5, 11.0, 10.75}}, {"sha\"256", 1024, {3.0}}}};
+  std::stringstream json;
+  write_bench_json(json, run);
+  const BenchRun back = read_bench_json(json);
+  EXPECT_EQ(back.commit, "abc123");
+  ASSERT_EQ(back.results.size(), 2U);
+  EXPECT_EQ(back.results[0].hasher, "ai");
+  EXPECT_EQ(back.results[0].size, 64U);
+  EXPECT_EQ(back.results[0].samples_ns, run.results[0].samples_ns);
+  EXPECT_DOUBLE_EQ(back.results[0].ns_per_op(), 10.75);
+  EXPECT_EQ(back.results[1].hasher, "sha\"256");
+
+  std::istringstream truncated(R"({"commit": "x", "results": [{"hasher": "ai")");
+  EXPECT_THROW((void)read_bench_json(truncated), std::runtime_error);
+  std::istringstream empty_samples(
+      R"({"results": [{"hasher": "ai", "size": 1, "samples": []}]})");
+  EXPECT_THROW((void)read_bench_json(empty_samples), std::runtime_error);
+}
+
+TEST(BenchResultsTest, MannWhitneyFlagsOnlySignificantSlowdowns) {
+  const std::vector<double> fast = {100, 101, 99, 100.5, 100.2};
+  const std::vector<double> slow = {110, 111, 109, 112, 110.5};
+  const MannWhitney separated = mann_whitney_greater(slow, fast);
+  EXPECT_DOUBLE_EQ(separated.u, 25.0);
+  EXPECT_NEAR(separated.p_value, 0.0061, 0.0005);
+  EXPECT_GT(mann_whitney_greater(fast, slow).p_value, 0.99);
+  EXPECT_GT(mann_whitney_greater(fast, fast).p_value, 0.4);
+
+  std::vector<double> many_fast;
+  std::vector<double> many_slow;
+  for (int i = 0; i < 15; ++i) {
+    many_fast.push_back(100.0 + i % 5);
+    many_slow.push_back(110.0 + i % 5);
+  }
+  const BenchRun baseline{"base", {{"ai", 64, many_fast}, {"sha256", 64, many_fast}}};
+  const BenchRun current{"head", {{"ai", 64, many_slow}, {"sha256", 64, many_fast},
+                                  {"asmeninis", 64, many_fast}}};
+  const auto comparisons = compare_runs(baseline, current, 0.01, 0.03);
+  ASSERT_EQ(comparisons.size(), 2U);
+  EXPECT_TRUE(comparisons[0].regression);
+  EXPECT_NEAR(comparisons[0].change, 112.0 / 102.0 - 1.0, 1e-9);
+  EXPECT_FALSE(comparisons[1].regression);
+  EXPECT_FALSE(compare_runs(baseline, current, 0.01, 0.5)[0].regression);
+}
+
+TEST(SacTest, BitCounterMatchesPerBitCounts) {
+  std::array<std::uint64_t, sac::kDigestBits> sliced{};
+  std::array<std::uint64_t, sac::kDigestBits> expected{};
+  sac::DigestBitCounter counter(sliced.data());
+  for (std::uint64_t i = 0; i < 1000; ++i) {
+    sac::DigestWords word{};
+    for (std::size_t w = 0; w < word.size(); ++w) {
+      word[w] = sac::detail::sample_word(7, i * 4 + w) & (w == 1 ? 0 : ~0ULL);
+      for (std::size_t bit = 0; bit < 64; ++bit) {
+        expected[w * 64 + bit] += (word[w] >> bit) & 1U;
+      }
+    }
+    counter.add(word);
+  }
+  counter.flush();
+  EXPECT_EQ(sliced, expected);
+}
+
+TEST(SacTest, MatrixIsNearHalfAndRawDigestsMatchHex) {
+  const std::string input = "lietuva";
+  const std::vector<std::uint8_t> from_hex = hex_decode(hasher.hash256bit(input));
+  EXPECT_EQ(sac::detail::digest_words(hasher, input), sac::detail::load_words(from_hex.data()));
+  EXPECT_EQ(sac::detail::digest_words(Hasher{}, input),
+            sac::detail::load_words(hex_decode(Hasher{}.hash256bit(input)).data()));
+
+  sac::SacOptions options;
+  options.samples = 256;
+  options.input_bytes = 2;
+  const sac::SacResult result = sac::analyze(SHA256_Hasher{}, options);
+  EXPECT_EQ(result.input_bits, 16U);
+  std::uint64_t pairs = 0;
+  for (const std::uint64_t count : result.distances) {
+    pairs += count;
+  }
+  EXPECT_EQ(pairs, 256U * 16U);
+
+  const sac::SacSummary summary = sac::summarize(result);
+  EXPECT_NEAR(summary.mean_flip_probability, 0.5, 0.01);
+  EXPECT_LT(std::abs(summary.sac_z), 5.0);
+  EXPECT_LT(std::abs(summary.bias_z), 5.0);
+  EXPECT_NEAR(summary.mean_distance, 128.0, 2.0);
+  EXPECT_EQ(sac::summarize(sac::analyze(SHA256_Hasher{}, options)).sac_chi_squared,
+            summary.sac_chi_squared);
+}
+
+TEST(SacTest, LegacyHasherResultDoesNotDependOnWorkers) {
+  sac::SacOptions options;
+  options.samples = 512;
+  options.input_bytes = 4;
+  ThreadPool one(1);
+  ThreadPool four(4);
+  const sac::SacResult split_once = sac::analyze(Hasher{}, options, one);
+  const sac::SacResult split_more = sac::analyze(Hasher{}, options, four);
+  EXPECT_EQ(split_once.flips, split_more.flips);
+  EXPECT_EQ(split_once.ones, split_more.ones);
+  EXPECT_EQ(split_once.distances, split_more.distances);
+}
+
+TEST(RhoTest, DistinguishedPointTableReturnsFirstTrail) {
+  rho::DistinguishedPointTable table(4);
+  EXPECT_EQ(table.capacity(), 4U);
+  EXPECT_FALSE(table.insert(0, {1, 10}));
+  EXPECT_FALSE(table.insert(1U << 20U, {2, 20}));
+  const auto existing = table.insert(0, {3, 30});
+  ASSERT_TRUE(existing);
+  EXPECT_EQ(existing->start, 1U);
+  EXPECT_EQ(existing->length, 10U);
+  EXPECT_EQ(table.size(), 2U);
+  EXPECT_FALSE(table.insert(5, {4, 1}));
+  EXPECT_FALSE(table.insert(6, {5, 1}));
+  EXPECT_THROW((void)table.insert(7, {6, 1}), std::length_error);
+}
+
+TEST(RhoTest, FindsTruncatedCollisions) {
+  rho::RhoOptions options;
+  options.bits = 24;
+  options.distinguished_bits = 4;
+  auto check = [&](const auto &hasher) {
+    const rho::RhoCollision found = rho::find_collision(hasher, options);
+    EXPECT_NE(found.first, found.second);
+    EXPECT_EQ(found.first.size(), 6U);
+    const auto first = digest_bytes<3>(hasher, found.first);
+    EXPECT_EQ(first, digest_bytes<3>(hasher, found.second));
+    EXPECT_EQ(found.value, first[0] | first[1] << 8U | first[2] << 16U);
+    EXPECT_GT(found.distinguished_points, 0U);
+  };
+  check(SHA256_Hasher{});
+  check(AIHasher{});
+  // Few distinct asmeninis digests put short walks into cycles with no
+  // distinguished point, so it gets the default point density.
+  options.distinguished_bits = 0;
+  check(Hasher{});
+}
+
+TEST(DigestRunsTest, RadixSortMatchesStdSort) {
+  std::vector<DigestRecord> records(20000);
+  std::uint64_t state = 12345;
+  for (std::size_t i = 0; i < records.size(); ++i) {
+    for (auto &byte : records[i].digest) {
+      state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+      byte = static_cast<std::uint8_t>(state >> 60U);
+    }
+    records[i].source = records.size() - i;
+  }
+  std::vector<DigestRecord> sorted(records.size());
+  radix_sort_records(records, sorted);
+  std::sort(records.begin(), records.end());
+  EXPECT_EQ(sorted, records);
+}
+
+TEST(DigestRunsTest, MergeReportsDuplicatesAcrossRuns) {
+  const auto dir = std::filesystem::temp_directory_path() / "hashf_digest_runs_test";
+  std::filesystem::remove_all(dir);
+  std::vector<std::filesystem::path> runs;
+  {
+    DigestRunWriter writer(dir, 7);
+    for (std::uint64_t i = 0; i < 50;) {
+      const auto records = writer.append(std::min<std::size_t>(writer.free_records(), 50 - i));
+      for (DigestRecord &record : records) {
+        record.digest = SHA256_Hasher{}.digest(std::to_string(i % 40));
+        record.source = i++;
+      }
+      if (writer.free_records() == 0) {
+        writer.flush();
+      }
+    }
+    runs = writer.finish();
+  }
+  EXPECT_EQ(runs.size(), 8U);
+
+  std::vector<std::vector<std::uint64_t>> groups;
+  const MergeStats stats = merge_runs(runs, [&](const DuplicateDigest &duplicate) {
+    EXPECT_EQ(duplicate.digest, SHA256_Hasher{}.digest(std::to_string(duplicate.sources[0])));
+    groups.push_back(duplicate.sources);
+  });
+  EXPECT_EQ(stats.records, 50U);
+  EXPECT_EQ(stats.bytes, 50U * sizeof(DigestRecord));
+  EXPECT_EQ(stats.duplicate_digests, 10U);
+  EXPECT_EQ(stats.duplicate_records, 20U);
+  for (const auto &group : groups) {
+    ASSERT_EQ(group.size(), 2U);
+    EXPECT_EQ(group[1], group[0] + 40);
+  }
+  std::filesystem::remove_all(dir);
+}
+
+TEST(DigestRunsTest, RejectedRunsDoNotLeakDescriptors) {
+  const auto dir = std::filesystem::temp_directory_path() / "hashf_digest_runs_bad_test";
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  const std::vector<std::filesystem::path> runs = {dir / "run_0.bin"};
+  std::ofstream(runs[0], std::ios::binary) << std::string(sizeof(DigestRecord) + 1, 'x');
+  auto open_descriptors = []() {
+    return std::distance(std::filesystem::directory_iterator("/proc/self/fd"),
+                         std::filesystem::directory_iterator{});
+  };
+  const auto before = open_descriptors();
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_THROW(merge_runs(runs, [](const DuplicateDigest &) {}), std::runtime_error);
+  }
+  EXPECT_EQ(open_descriptors(), before);
+  std::filesystem::remove_all(dir);
+}
+
+TEST(XofTest, OutputIsPrefixConsistentAndStartsWithDigest) {
+  const AIHasher hasher;
+  for (const std::string &input :
+       {std::string(), std::string("a"), std::string(4096, 'x')}) {
+    const auto wide = hasher.hash_bytes(input, 200);
+    const auto narrow = hasher.hash_bytes(input, 45);
+    EXPECT_TRUE(std::equal(narrow.begin(), narrow.end(), wide.begin()));
+
+    const auto d32 = hasher.digest<32>(input);
+    const auto d8 = hasher.digest<8>(input);
+    EXPECT_TRUE(std::equal(d32.begin(), d32.end(), wide.begin()));
+    EXPECT_TRUE(std::equal(d8.begin(), d8.end(), wide.begin()));
+    std::string hex;
+    for (auto byte : d32) {
+      hex += "0123456789abcdef"[byte >> 4U];
+      hex += "0123456789abcdef"[byte & 0x0FU];
+    }
+    EXPECT_EQ(hex, hasher.hash256bit(input));
+    EXPECT_FALSE(std::equal(wide.begin(), wide.begin() + 32, wide.begin() + 32));
+
+    AIHasher::Reader reader = hasher.xof(input);
+    std::vector<std::uint8_t> pieces(200);
+    std::size_t offset = 0;
+    for (std::size_t step : {1U, 7U, 31U, 33U, 64U, 64U}) {
+      reader.read(std::span<std::uint8_t>(pieces).subspan(offset, step));
+      offset += step;
+    }
+    EXPECT_EQ(pieces, wide);
+  }
+}
+
+
+TEST(Hash64Test, DistinctAcrossLengthsAndSeeds) {
+  static_assert(AIHasher64::hash("a") != AIHasher64::hash("b"));
+  std::unordered_set<std::uint64_t> seen;
+  std::string input;
+  for (int length = 0; length < 200; ++length) {
+    EXPECT_TRUE(seen.insert(AIHasher64::hash(input)).second) << length;
+    EXPECT_NE(AIHasher64::hash(input, 1), AIHasher64::hash(input)) << length;
+    input.push_back(static_cast<char>('a' + length % 26));
+  }
+  EXPECT_EQ(AIHasher64{}(std::string("collision")),
+            static_cast<std::size_t>(AIHasher64::hash("collision")));
+}
+
+TEST(FlatStringMapTest, MatchesUnorderedMap) {
+  FlatStringMap<int> map;
+  std::unordered_map<std::string, int> reference;
+  std::uint64_t state = 0x9E3779B97F4A7C15ULL;
+  for (int step = 0; step < 20000; ++step) {
+    state ^= state << 13U;
+    state ^= state >> 7U;
+    state ^= state << 17U;
+    const std::string key = "k" + std::to_string(state % 3000);
+    switch (state >> 62U) {
+    case 0:
+      EXPECT_EQ(map.erase(key), reference.erase(key) == 1) << key;
+      break;
+    case 1:
+      EXPECT_EQ(map.insert_or_assign(key, step),
+                reference.insert_or_assign(key, step).second);
+      break;
+    default:
+      map[key] += 1;
+      reference[key] += 1;
+      break;
+    }
+  }
+  ASSERT_EQ(map.size(), reference.size());
+  for (const auto &[key, value] : reference) {
+    const int *found = map.find(key);
+    ASSERT_NE(found, nullptr) << key;
+    EXPECT_EQ(*found, value) << key;
+  }
+  for (const auto &[key, value] : map) {
+    EXPECT_EQ(reference.at(key), value);
+  }
+  EXPECT_FALSE(map.contains("missing"));
+}
+
+
+namespace {
+
+constexpr std::array<std::uint8_t, 32> from_hex(std::string_view hex) {
+  auto nibble = [](char c) {
+    return static_cast<std::uint8_t>(c <= '9' ? c - '0' : c - 'a' + 10);
+  };
+  std::array<std::uint8_t, 32> out{};
+  for (std::size_t i = 0; i < out.size(); ++i) {
+    out[i] = static_cast<std::uint8_t>(nibble(hex[2 * i]) << 4U | nibble(hex[2 * i + 1]));
+  }
+  return out;
+}
+
+static_assert(AIHasher::constant_digest("a") ==
+              from_hex("7f158916e9e17507e5ab2e975c5635f68a5cdaa0bcda8efc02e9a5f195fee117"));
+static_assert(AIHasher::constant_digest("") ==
+              from_hex("3b3dccdade73aacf26129fa7281199667ec20fa92b0cd8613f3368e6ccdd6003"));
+static_assert("lietuva"_ai64 != "Lietuva"_ai64);
+
+} // namespace
+
+TEST(ConstexprHashTest, MatchesRuntimeDigest) {
+  const AIHasher hasher;
+  std::string input;
+  for (int length = 0; length < 300; ++length) {
+    EXPECT_EQ(AIHasher::constant_digest(input), hasher.digest<32>(input)) << length;
+    input.push_back(static_cast<char>(length * 37 + 11));
+  }
+  const std::string large(5000, 'p');
+  EXPECT_EQ(AIHasher::constant_digest(large), hasher.digest<32>(large));
+  switch (AIHasher::key64("verify")) {
+  case "validate"_ai64:
+    FAIL() << "switch matched the wrong key";
+  case "verify"_ai64:
+    break;
+  default:
+    FAIL() << "switch missed its key";
+  }
 }
\ No newline at end of file
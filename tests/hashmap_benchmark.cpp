@@ -0,0 +1,114 @@
+#include "benchmark_modes.h"
+#include <Timer.h>
+#include <constants.h>
+#include <crypto/AIHasher64.h>
+#include <crypto/flat_string_map.h>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// Every word of the collision corpus, or synthetic 10-character keys when
+// the corpus has not been generated.
+std::vector<std::string> load_keys(std::size_t limit) {
+  std::vector<std::string> keys;
+  std::error_code ec;
+  if (std::filesystem::is_directory(kCollisionPath, ec)) {
+    for (const auto &entry : std::filesystem::directory_iterator(kCollisionPath)) {
+      std::ifstream in(entry.path());
+      std::string word;
+      while (keys.size() < limit && in >> word) {
+        keys.push_back(word);
+      }
+    }
+  }
+  if (keys.empty()) {
+    std::cout << "no collision corpus under " << kCollisionPath
+              << ", using synthetic keys\n";
+    std::uint64_t state = 0x243F6A8885A308D3ULL;
+    while (keys.size() < limit) {
+      state ^= state << 13U;
+      state ^= state >> 7U;
+      state ^= state << 17U;
+      std::string key(10, 'a');
+      for (std::size_t i = 0; i < key.size(); ++i) {
+        key[i] = kAlphabet[(state >> (i * 6U)) % kAlphabet.size()];
+      }
+      keys.push_back(std::move(key));
+    }
+  }
+  return keys;
+}
+
+template <typename Map>
+void run(const char *label, const std::vector<std::string> &keys,
+         const std::vector<std::string> &misses) {
+  Map map;
+  Timer t;
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    map[keys[i]] = static_cast<std::uint32_t>(i);
+  }
+  const double insert = t.elapsed();
+
+  t.reset();
+  std::uint64_t sum = 0;
+  for (const auto &key : keys) {
+    sum += map.find(key) != map.end() ? 1U : 0U;
+  }
+  const double hit = t.elapsed();
+
+  t.reset();
+  for (const auto &key : misses) {
+    sum += map.find(key) != map.end() ? 1U : 0U;
+  }
+  const double miss = t.elapsed();
+
+  auto mops = [](std::size_t n, double s) { return static_cast<double>(n) / s / 1e6; };
+  std::cout << std::fixed << std::setprecision(2) << "| " << label << " | "
+            << mops(keys.size(), insert) << " | " << mops(keys.size(), hit)
+            << " | " << mops(misses.size(), miss) << " | " << map.size()
+            << " |\n";
+  volatile std::uint64_t keep = sum;
+  (void)keep;
+}
+
+// Gives FlatStringMap the find()/end() shape of the standard maps.
+template <typename Value> struct FlatAdapter : FlatStringMap<Value> {
+  struct End {};
+  End end() const { return {}; }
+  struct Found {
+    const Value *value;
+    bool operator!=(End) const { return value != nullptr; }
+  };
+  Found find(std::string_view key) const { return {FlatStringMap<Value>::find(key)}; }
+};
+
+} // namespace
+
+int benchmark_hash_map(int argc, char *argv[]) {
+  const std::size_t limit =
+      argc > 2 ? static_cast<std::size_t>(std::stoull(argv[2])) : 2000000U;
+  const std::vector<std::string> keys = load_keys(limit);
+  std::vector<std::string> misses;
+  misses.reserve(keys.size());
+  for (const auto &key : keys) {
+    misses.push_back(key + "#");
+  }
+
+  std::cout << keys.size() << " keys\n\n";
+  std::cout << "| Map | Insert Mops/s | Hit Mops/s | Miss Mops/s | Size |\n";
+  std::cout << "| :-- | ------------: | ---------: | ----------: | ---: |\n";
+  run<std::unordered_map<std::string, std::uint32_t>>(
+      "unordered_map + std::hash", keys, misses);
+  run<std::unordered_map<std::string, std::uint32_t, AIHasher64, std::equal_to<>>>(
+      "unordered_map + AIHasher64", keys, misses);
+  run<FlatAdapter<std::uint32_t>>("FlatStringMap + AIHasher64", keys, misses);
+  return 0;
+}
\ No newline at end of file
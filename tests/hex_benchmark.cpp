@@ -0,0 +1,59 @@
+#include "benchmark_modes.h"
+#include <hex.h>
+#include <Timer.h>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Encodes and decodes `size`-byte buffers `rounds` times with every kernel;
+// throughput is reported in input bytes per second.
+void run_size(std::size_t size, std::size_t rounds) {
+  std::vector<std::uint8_t> bytes(size);
+  for (std::size_t i = 0; i < size; ++i) {
+    bytes[i] = static_cast<std::uint8_t>(i * 131 + 17);
+  }
+  std::string text(size * 2, '\0');
+  std::vector<std::uint8_t> decoded(size);
+
+  for (const HexCodec &codec : hex_codecs()) {
+    Timer t;
+    for (std::size_t r = 0; r < rounds; ++r) {
+      codec.encode(bytes.data(), size, text.data());
+    }
+    const double encode = t.elapsed();
+
+    t.reset();
+    std::size_t failures = 0;
+    for (std::size_t r = 0; r < rounds; ++r) {
+      failures += codec.decode(text.data(), size, decoded.data()) != kHexValid;
+    }
+    const double decode = t.elapsed();
+    if (failures != 0 || decoded != bytes) {
+      std::cerr << codec.name << " failed to round-trip " << size << " bytes\n";
+    }
+
+    const double total = static_cast<double>(size * rounds) / 1e6;
+    std::cout << std::fixed << std::setprecision(0) << "| " << size << " | "
+              << codec.name << " | " << total / encode << " | " << total / decode
+              << " |\n";
+  }
+}
+
+} // namespace
+
+int benchmark_hex(int argc, char *argv[]) {
+  const std::size_t scale =
+      argc > 2 ? static_cast<std::size_t>(std::stoull(argv[2])) : 1U;
+
+  std::cout << "| Bytes | Kernel | Encode (MB/s) | Decode (MB/s) |\n";
+  std::cout << "| ----: | :----- | ------------: | ------------: |\n";
+  run_size(32, 2000000 * scale);
+  run_size(4096, 20000 * scale);
+  run_size(1 << 20, 80 * scale);
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include "benchmark_modes.h"
+#include <crypto/hasher_registry.h>
+#include <Timer.h>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <latency_histogram.h>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread_pool.h>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t kSizes[] = {16, 64, 256, 1024, 4096, 16384};
+
+std::vector<std::string> make_inputs(std::size_t count, std::size_t length) {
+  std::vector<std::string> inputs(count, std::string(length, 'a'));
+  for (std::size_t i = 0; i < count; ++i) {
+    for (std::size_t b = 0; b < length && b < 8; ++b) {
+      inputs[i][b] = static_cast<char>('a' + ((i >> (b * 3U)) & 7U));
+    }
+  }
+  return inputs;
+}
+
+// Every call is timed on its own; each pool worker fills a private
+// histogram and merges it once at the end.
+template <ConcreteHasher H>
+LatencyHistogram sample(const H &hasher, const std::vector<std::string> &inputs,
+                        unsigned threads) {
+  LatencyHistogram merged;
+  std::mutex mutex;
+  ThreadPool::global().parallel_for(
+      inputs.size(), 64,
+      [&](std::size_t begin, std::size_t end) {
+        LatencyHistogram local;
+        std::size_t sink = 0;
+        for (std::size_t i = begin; i < end; ++i) {
+          const std::uint64_t start = TscClock::now();
+          sink += static_cast<unsigned char>(hasher.hash256bit(inputs[i])[0]);
+          local.record(TscClock::to_ns(TscClock::now() - start));
+        }
+        volatile std::size_t keep = sink;
+        (void)keep;
+        std::lock_guard lock(mutex);
+        merged.merge(local);
+      },
+      threads);
+  return merged;
+}
+
+} // namespace
+
+// Per-call latency percentiles for every registered hasher and a range of
+// message sizes. Optional arguments: samples per size and worker threads.
+int benchmark_latency(int argc, char *argv[]) {
+  std::size_t samples = 2000U;
+  unsigned threads = 1U;
+  try {
+    if (argc > 2) {
+      samples = static_cast<std::size_t>(std::stoull(argv[2]));
+    }
+    if (argc > 3) {
+      threads = static_cast<unsigned>(std::stoul(argv[3]));
+    }
+    if (samples == 0 || threads == 0) {
+      throw std::invalid_argument("samples and threads must be at least 1");
+    }
+  } catch (const std::exception &e) {
+    std::cerr << "bad argument: " << e.what() << '\n';
+    return 1;
+  }
+
+  std::cout << samples << " samples per size, " << threads << " thread(s), clock "
+            << (TscClock::uses_tsc() ? "tsc" : "CLOCK_MONOTONIC_RAW") << "\n\n";
+  std::cout << "| Hasher | Bytes | p50 ns | p99 ns | p999 ns | Max ns |\n";
+  std::cout << "| :----- | ----: | -----: | -----: | ------: | -----: |\n";
+  for (const std::size_t size : kSizes) {
+    const std::vector<std::string> inputs = make_inputs(samples, size);
+    for (const std::string_view name : HasherRegistry::names()) {
+      HasherRegistry::visit(name, [&](const auto &hasher) {
+        hasher.hash256bit(inputs.front());
+        const LatencyHistogram h = sample(hasher, inputs, threads);
+        std::cout << "| " << name << " | " << size << " | " << h.percentile(0.5)
+                  << " | " << h.percentile(0.99) << " | " << h.percentile(0.999)
+                  << " | " << h.max() << " |\n";
+      });
+    }
+  }
+  return 0;
+}
\ No newline at end of file
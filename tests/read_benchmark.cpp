@@ -0,0 +1,142 @@
+#include "benchmark_modes.h"
+#include <FileRead.h>
+#include <Timer.h>
+#include <async_file_reader.h>
+#include <crypto/hasher_registry.h>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+std::vector<std::filesystem::path> write_files(const std::filesystem::path &dir,
+                                               std::size_t count, std::size_t size) {
+  std::filesystem::create_directories(dir);
+  std::vector<std::filesystem::path> files;
+  std::uint64_t state = 0x243F6A8885A308D3ULL;
+  std::string data;
+  for (std::size_t i = 0; i < count; ++i) {
+    // Sizes spread over [size / 2, 3 * size / 2).
+    data.resize(size / 2 + i * 7919 % (size + 1));
+    for (auto &c : data) {
+      state ^= state << 13U;
+      state ^= state >> 7U;
+      state ^= state << 17U;
+      c = static_cast<char>(state);
+    }
+    files.push_back(dir / ("file_" + std::to_string(i)));
+    std::ofstream(files.back(), std::ios::binary) << data;
+  }
+  return files;
+}
+
+// Best effort: write back and drop the files' pages so the next read hits
+// the disk. Only clean pages can be dropped without privileges.
+void drop_page_cache(const std::vector<std::filesystem::path> &files) {
+#if defined(__linux__)
+  for (const auto &path : files) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd >= 0) {
+      ::fdatasync(fd);
+      ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+      ::close(fd);
+    }
+  }
+#else
+  (void)files;
+#endif
+}
+
+} // namespace
+
+int benchmark_file_reading(int argc, char *argv[]) {
+  std::size_t count = 2000U;
+  std::size_t kib = 64U;
+  const std::string hasher_name = argc > 4 ? argv[4] : "sha256";
+  unsigned depth = 32U;
+  std::unique_ptr<IHasher> hasher;
+  try {
+    if (argc > 2) {
+      count = static_cast<std::size_t>(std::stoull(argv[2]));
+    }
+    if (argc > 3) {
+      kib = static_cast<std::size_t>(std::stoull(argv[3]));
+    }
+    if (argc > 5) {
+      depth = static_cast<unsigned>(std::stoul(argv[5]));
+    }
+    if (count == 0 || depth == 0) {
+      throw std::invalid_argument("file count and queue depth must be at least 1");
+    }
+    hasher = HasherRegistry::make(hasher_name);
+  } catch (const std::exception &e) {
+    std::cerr << "bad argument: " << e.what() << '\n';
+    return 1;
+  }
+
+  const auto dir = std::filesystem::temp_directory_path() / "hashf_read_benchmark";
+  std::filesystem::remove_all(dir);
+  const auto files = write_files(dir, count, kib * 1024);
+  std::uintmax_t total = 0;
+  for (const auto &path : files) {
+    total += std::filesystem::file_size(path);
+  }
+
+  std::vector<std::string> expected(files.size());
+  auto run = [&](const char *label, bool cold, auto &&read_and_hash) {
+    if (cold) {
+      drop_page_cache(files);
+    }
+    std::vector<std::string> digests(files.size());
+    Timer t;
+    read_and_hash(digests);
+    const double elapsed = t.elapsed();
+    if (expected.front().empty()) {
+      expected = digests;
+    } else if (digests != expected) {
+      std::cerr << label << " produced different digests\n";
+    }
+    std::cout << std::fixed << std::setprecision(0) << "| " << label << " | "
+              << (cold ? "cold" : "warm") << " | "
+              << static_cast<double>(total) / 1e6 / elapsed << " | "
+              << static_cast<double>(files.size()) / elapsed << " |\n";
+  };
+
+  AsyncFileReader uring({depth});
+  AsyncFileReader pooled({depth, std::size_t{1} << 20U, true});
+  std::cout << files.size() << " files, " << total / (1 << 20U) << " MiB, "
+            << hasher_name << ", queue depth " << depth << ", reader backend "
+            << uring.backend() << "\n\n";
+  std::cout << "| Path | Cache | MB/s | Files/s |\n";
+  std::cout << "| :--- | :---- | ---: | ------: |\n";
+  for (const bool cold : {true, false}) {
+    run("ReadFile (sequential)", cold, [&](std::vector<std::string> &digests) {
+      for (std::size_t i = 0; i < files.size(); ++i) {
+        digests[i] = hasher->hash256bit(ReadFile(files[i]));
+      }
+    });
+    for (AsyncFileReader *reader : {&pooled, &uring}) {
+      const std::string label = std::string("AsyncFileReader (") + reader->backend() + ")";
+      run(label.c_str(), cold, [&](std::vector<std::string> &digests) {
+        reader->read_all(
+            files, [&](std::size_t index, std::string_view data) {
+              digests[index] = hasher->hash256bit(std::string(data));
+            });
+      });
+    }
+  }
+  std::filesystem::remove_all(dir);
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,181 @@
+#include "benchmark_modes.h"
+#include <bench_results.h>
+#include <constants.h>
+#include <crypto/hasher_registry.h>
+#include <Timer.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifndef HASHF_GIT_COMMIT
+#define HASHF_GIT_COMMIT "unknown"
+#endif
+
+namespace {
+
+constexpr std::size_t kSizes[] = {64, 1024, 16384, 262144};
+constexpr std::uint64_t kRepetitionNs = 5000000;
+
+std::string make_input(std::size_t size) {
+  std::string input(size, '\0');
+  std::uint64_t state = 0x9E3779B97F4A7C15ULL ^ size;
+  for (char &c : input) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    c = static_cast<char>(state >> 56U);
+  }
+  return input;
+}
+
+// Each sample is the mean over enough calls to fill about 5 ms, so one
+// sample is not a single preemptible call and repetitions are comparable.
+// The call count is found by doubling a warm batch until it takes 1 ms.
+template <ConcreteHasher H>
+std::vector<double> time_hasher(const H &hasher, const std::string &input,
+                                int repetitions) {
+  std::size_t sink = 0;
+  auto batch_ns = [&](std::uint64_t calls) {
+    Timer t;
+    for (std::uint64_t i = 0; i < calls; ++i) {
+      sink += static_cast<unsigned char>(hasher.hash256bit(input)[0]);
+    }
+    return std::max<std::uint64_t>(1, t.elapsed_ns());
+  };
+  batch_ns(1);
+  std::uint64_t calls = 1;
+  std::uint64_t elapsed = batch_ns(calls);
+  while (elapsed < kRepetitionNs / 5 && calls < 1000000) {
+    calls *= 2;
+    elapsed = batch_ns(calls);
+  }
+  calls = std::clamp<std::uint64_t>(calls * kRepetitionNs / elapsed, 1, 1000000);
+
+  std::vector<double> samples;
+  samples.reserve(static_cast<std::size_t>(repetitions));
+  for (int r = 0; r < repetitions; ++r) {
+    samples.push_back(static_cast<double>(batch_ns(calls)) / static_cast<double>(calls));
+  }
+  volatile std::size_t keep = sink;
+  (void)keep;
+  return samples;
+}
+
+} // namespace
+
+// Writes ns/op samples of every registered hasher at each size as JSON for
+// a later compare. Arguments: output file, repetitions, commit id.
+int benchmark_record(int argc, char *argv[]) {
+  const std::filesystem::path out =
+      argc > 2 ? std::filesystem::path(argv[2]) : kResultsPath / "benchmark.json";
+  int repetitions = 15;
+  try {
+    if (argc > 3) {
+      repetitions = std::stoi(argv[3]);
+    }
+    if (repetitions < 1) {
+      throw std::invalid_argument("repetitions must be at least 1");
+    }
+  } catch (const std::exception &e) {
+    std::cerr << "bad argument: " << e.what() << '\n';
+    return 1;
+  }
+  BenchRun run;
+  run.commit = argc > 4 ? argv[4] : HASHF_GIT_COMMIT;
+
+  for (const std::size_t size : kSizes) {
+    const std::string input = make_input(size);
+    for (const std::string_view name : HasherRegistry::names()) {
+      HasherRegistry::visit(name, [&](const auto &hasher) {
+        BenchResult result{std::string(name), size, time_hasher(hasher, input, repetitions)};
+        std::cout << name << " " << size << " B: " << std::fixed << std::setprecision(1)
+                  << result.ns_per_op() << " ns/op (sd " << result.stddev() << ")\n";
+        run.results.push_back(std::move(result));
+      });
+    }
+  }
+
+  if (out.has_parent_path()) {
+    std::filesystem::create_directories(out.parent_path());
+  }
+  std::ofstream stream(out, std::ios::trunc);
+  if (!stream) {
+    std::cerr << "cannot write " << out << '\n';
+    return 1;
+  }
+  write_bench_json(stream, run);
+  std::cout << "wrote " << out << " (commit " << run.commit << ")\n";
+  return 0;
+}
+
+// Compares two recorded runs and exits with 1 if any hasher/size got
+// significantly slower. Arguments: baseline file, current file, alpha,
+// smallest slowdown worth failing on.
+int benchmark_compare(int argc, char *argv[]) {
+  if (argc < 4) {
+    std::cerr << "usage: benchmark compare <baseline.json> <current.json> "
+                 "[alpha=0.01] [min_slowdown=0.03]\n";
+    return 2;
+  }
+  double alpha = 0.01;
+  double min_slowdown = 0.03;
+  try {
+    if (argc > 4) {
+      alpha = std::stod(argv[4]);
+    }
+    if (argc > 5) {
+      min_slowdown = std::stod(argv[5]);
+    }
+    if (!(alpha > 0.0 && alpha < 1.0) || !(min_slowdown >= 0.0)) {
+      throw std::invalid_argument("alpha must be in (0, 1) and min_slowdown at least 0");
+    }
+  } catch (const std::exception &e) {
+    std::cerr << "bad argument: " << e.what() << '\n';
+    return 2;
+  }
+
+  BenchRun baseline;
+  BenchRun current;
+  try {
+    std::ifstream baseline_stream(argv[2]);
+    std::ifstream current_stream(argv[3]);
+    if (!baseline_stream || !current_stream) {
+      std::cerr << "cannot open " << (baseline_stream ? argv[3] : argv[2]) << '\n';
+      return 2;
+    }
+    baseline = read_bench_json(baseline_stream);
+    current = read_bench_json(current_stream);
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << '\n';
+    return 2;
+  }
+
+  const auto comparisons = compare_runs(baseline, current, alpha, min_slowdown);
+  std::cout << "baseline " << baseline.commit << " -> current " << current.commit
+            << " (alpha " << alpha << ", min slowdown " << min_slowdown * 100.0
+            << "%)\n\n";
+  std::cout << "| Hasher | Bytes | Baseline ns | Current ns | Change % | p | Verdict |\n";
+  std::cout << "| :----- | ----: | ----------: | ---------: | -------: | -: | :------ |\n";
+  int regressions = 0;
+  for (const auto &c : comparisons) {
+    regressions += c.regression ? 1 : 0;
+    std::cout << std::fixed << std::setprecision(1) << "| " << c.hasher << " | "
+              << c.size << " | " << c.baseline_ns << " | " << c.current_ns << " | "
+              << std::showpos << c.change * 100.0 << std::noshowpos << " | "
+              << std::setprecision(4) << c.p_value << " | "
+              << (c.regression ? "**slower**" : "ok") << " |\n";
+  }
+  if (comparisons.empty()) {
+    std::cerr << "the runs have no hasher and size in common\n";
+    return 2;
+  }
+  std::cout << '\n' << regressions << " regression(s)\n";
+  return regressions == 0 ? 0 : 1;
+}
\ No newline at end of file
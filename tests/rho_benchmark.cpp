@@ -0,0 +1,69 @@
+#include "benchmark_modes.h"
+#include <crypto/hasher_registry.h>
+#include <rho_collision.h>
+#include <cstdint>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <thread_pool.h>
+#include <vector>
+
+// Collisions of truncated digests with parallel Pollard rho. Optional
+// arguments: digest bits (default 32), searches per hasher (default 3) and
+// a single hasher name. A random function needs about 2^(bits/2) calls, so
+// each extra bit costs sqrt(2) more time.
+int benchmark_rho(int argc, char *argv[]) {
+  rho::RhoOptions options;
+  int trials = 3;
+  try {
+    if (argc > 2) {
+      options.bits = static_cast<unsigned>(std::stoul(argv[2]));
+    }
+    if (argc > 3) {
+      trials = std::stoi(argv[3]);
+    }
+  } catch (const std::exception &e) {
+    std::cerr << "bad argument: " << e.what() << '\n';
+    return 1;
+  }
+  std::vector<std::string_view> names = {"asmeninis", "ai", "sha256"};
+  if (argc > 4) {
+    names = {argv[4]};
+  }
+
+  std::cout << options.bits << "-bit digests, " << trials << " search(es) per hasher, "
+            << ThreadPool::global().size() << " thread(s), expected "
+            << static_cast<std::uint64_t>(rho::expected_evaluations(options.bits))
+            << " calls\n\n";
+  std::vector<rho::RhoCollision> results;
+  std::map<std::string, double> ratio_sums;
+  try {
+    for (const std::string_view name : names) {
+      HasherRegistry::visit(name, [&](const auto &hasher) {
+        for (int trial = 0; trial < trials; ++trial) {
+          options.seed = static_cast<std::uint64_t>(trial) + 1;
+          results.push_back(rho::find_collision(hasher, options));
+          ratio_sums[results.back().hasher] +=
+              static_cast<double>(results.back().evaluations) /
+              rho::expected_evaluations(options.bits);
+        }
+      });
+    }
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << '\n';
+    return 1;
+  }
+  rho::write_table(std::cout, results);
+
+  // A ratio well under 1 means collisions come sooner than for a random
+  // function of the same width.
+  std::cout << "\n| Hasher | Mean calls / expected |\n| :----- | --------------------: |\n"
+            << std::fixed << std::setprecision(2);
+  for (const auto &[hasher, sum] : ratio_sums) {
+    std::cout << "| " << hasher << " | " << sum / trials << " |\n";
+  }
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#include "benchmark_modes.h"
+#include <constants.h>
+#include <crypto/hasher_registry.h>
+#include <sac_analyzer.h>
+#include <Timer.h>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread_pool.h>
+#include <vector>
+
+// Strict avalanche matrix and output bit bias of every registered hasher.
+// Optional arguments: random messages per hasher, message length in bytes
+// and a single hasher name. Each message costs length * 8 + 1 digests, so
+// the defaults evaluate 2^16 * 64 = 4.2M flipped pairs per hasher.
+int benchmark_sac(int argc, char *argv[]) {
+  sac::SacOptions options;
+  try {
+    if (argc > 2) {
+      options.samples = std::stoull(argv[2]);
+    }
+    if (argc > 3) {
+      options.input_bytes = std::stoul(argv[3]);
+    }
+  } catch (const std::exception &e) {
+    std::cerr << "bad argument: " << e.what() << '\n';
+    return 1;
+  }
+  if (options.input_bytes == 0) {
+    std::cerr << "message length must be at least one byte\n";
+    return 1;
+  }
+
+  std::vector<std::string_view> names;
+  if (argc > 4) {
+    names.emplace_back(argv[4]);
+  } else {
+    const auto all = HasherRegistry::names();
+    names.assign(all.begin(), all.end());
+  }
+
+  std::cout << options.samples << " messages of " << options.input_bytes << " bytes, "
+            << ThreadPool::global().size() << " thread(s)\n\n";
+  std::vector<sac::SacResult> results;
+  try {
+    for (const std::string_view name : names) {
+      HasherRegistry::visit(name, [&](const auto &hasher) {
+        Timer t;
+        results.push_back(sac::analyze(hasher, options));
+        const double seconds = t.elapsed();
+        const double pairs =
+            static_cast<double>(options.samples) * static_cast<double>(options.input_bytes * 8);
+        std::cout << name << ": " << seconds << " s, " << pairs / seconds * 1e-6
+                  << " M pairs/s\n";
+        sac::write_matrix(results.back(), kResultsPath / "sac" / (std::string(name) + "_matrix.txt"));
+        sac::write_bias(results.back(), kResultsPath / "sac" / (std::string(name) + "_bias.txt"));
+      });
+    }
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << '\n';
+    return 1;
+  }
+  std::cout << '\n';
+  sac::write_summary_table(std::cout, results);
+  return 0;
+}
\ No newline at end of file
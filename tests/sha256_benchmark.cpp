@@ -0,0 +1,136 @@
+#include "benchmark_modes.h"
+#include <crypto/sha256_hasher.h>
+#include <Timer.h>
+#include <openssl/evp.h>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+// The pre-pooling implementation: a fresh context and an implicit algorithm
+// lookup per message. Kept here only as the benchmark baseline.
+std::string per_call_context_sha256(const std::string &input) {
+  EVP_MD_CTX *mdctx = EVP_MD_CTX_new();
+  unsigned char md_value[EVP_MAX_MD_SIZE];
+  unsigned int md_len = 0;
+  EVP_DigestInit_ex(mdctx, EVP_sha256(), nullptr);
+  EVP_DigestUpdate(mdctx, input.data(), input.size());
+  EVP_DigestFinal_ex(mdctx, md_value, &md_len);
+  EVP_MD_CTX_free(mdctx);
+  static const char hex_chars[] = "0123456789abcdef";
+  std::string output;
+  output.reserve(md_len * 2);
+  for (unsigned int i = 0; i < md_len; ++i) {
+    output.push_back(hex_chars[(md_value[i] >> 4) & 0x0F]);
+    output.push_back(hex_chars[md_value[i] & 0x0F]);
+  }
+  return output;
+}
+
+// The one-shot API with an explicitly fetched algorithm: no context to keep,
+// but OpenSSL allocates and frees one inside every call.
+std::size_t one_shot_sha256(const EVP_MD *md, const std::string &input) {
+  unsigned char md_value[EVP_MAX_MD_SIZE];
+  unsigned int md_len = 0;
+  EVP_Digest(input.data(), input.size(), md_value, &md_len, md, nullptr);
+  return md_value[0];
+}
+
+template <typename Fn>
+void report(const char *label, std::size_t count, double &baseline, Fn &&run) {
+  Timer t;
+  const std::size_t sink = run();
+  const double elapsed = t.elapsed();
+  if (baseline == 0.0) {
+    baseline = elapsed;
+  }
+  std::cout << std::fixed << std::setprecision(0) << "| " << label << " | "
+            << static_cast<double>(count) / elapsed << " | "
+            << std::setprecision(2) << baseline / elapsed << " |\n";
+  volatile std::size_t keep = sink;
+  (void)keep;
+}
+
+} // namespace
+
+int benchmark_sha256_short(int argc, char *argv[]) {
+  std::size_t count = 1000000U;
+  std::size_t length = 10U;
+  try {
+    if (argc > 2) {
+      count = static_cast<std::size_t>(std::stoull(argv[2]));
+    }
+    if (argc > 3) {
+      length = static_cast<std::size_t>(std::stoull(argv[3]));
+    }
+    if (count == 0) {
+      throw std::invalid_argument("count must be at least 1");
+    }
+  } catch (const std::exception &e) {
+    std::cerr << "bad argument: " << e.what() << '\n';
+    return 1;
+  }
+
+  std::vector<std::string> inputs(count, std::string(length, 'a'));
+  for (std::size_t i = 0; i < count; ++i) {
+    for (std::size_t b = 0; b < length && b < 8; ++b) {
+      inputs[i][b] = static_cast<char>('a' + ((i >> (b * 3U)) & 7U));
+    }
+  }
+
+  const SHA256_Hasher hasher;
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+  EVP_MD *md = EVP_MD_fetch(nullptr, "SHA256", nullptr);
+#else
+  const EVP_MD *md = EVP_sha256();
+#endif
+  if (per_call_context_sha256(inputs.front()) != hasher.hash256bit(inputs.front())) {
+    std::cerr << "pooled SHA-256 does not match the per-call baseline\n";
+    return 1;
+  }
+
+  std::cout << count << " messages of " << length << " bytes\n\n";
+  std::cout << "| Path | Hashes/s | Speedup |\n";
+  std::cout << "| :--- | -------: | ------: |\n";
+  double baseline = 0.0;
+  report("per-call context (before)", count, baseline, [&]() {
+    std::size_t sink = 0;
+    for (const auto &input : inputs) {
+      sink += per_call_context_sha256(input)[0];
+    }
+    return sink;
+  });
+  report("hash256bit", count, baseline, [&]() {
+    std::size_t sink = 0;
+    for (const auto &input : inputs) {
+      sink += hasher.hash256bit(input)[0];
+    }
+    return sink;
+  });
+  report("hash256bit_batch", count, baseline, [&]() {
+    return hasher.hash256bit_batch(inputs).back().size();
+  });
+  report("EVP_Digest one-shot", count, baseline, [&]() {
+    std::size_t sink = 0;
+    for (const auto &input : inputs) {
+      sink += one_shot_sha256(md, input);
+    }
+    return sink;
+  });
+  report("digest (raw bytes)", count, baseline, [&]() {
+    std::size_t sink = 0;
+    for (const auto &input : inputs) {
+      sink += hasher.digest(input)[0];
+    }
+    return sink;
+  });
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+  EVP_MD_free(md);
+#endif
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#include "benchmark_modes.h"
+#include <crypto/hasher_registry.h>
+#include <Timer.h>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <stage_profiler.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Where the time goes inside each hasher: per-stage cycles and calls from
+// stage_profiler over a batch of equal-length messages.
+int benchmark_stages(int argc, char *argv[]) {
+  if (!stage_profiler::kEnabled) {
+    std::cerr << "stage profiling is compiled out; configure with "
+                 "-DHASHF_INSTRUMENT=ON\n";
+    return 1;
+  }
+  const std::size_t count =
+      argc > 2 ? static_cast<std::size_t>(std::stoull(argv[2])) : 100000U;
+  const std::size_t length =
+      argc > 3 ? static_cast<std::size_t>(std::stoull(argv[3])) : 64U;
+  const bool json = argc > 4 && std::string_view(argv[4]) == "json";
+
+  std::vector<std::string> inputs(count, std::string(length, 'a'));
+  for (std::size_t i = 0; i < count; ++i) {
+    for (std::size_t b = 0; b < length && b < 8; ++b) {
+      inputs[i][b] = static_cast<char>('a' + ((i >> (b * 3U)) & 7U));
+    }
+  }
+
+  stage_profiler::reset();
+  std::cout << count << " messages of " << length << " bytes, clock "
+            << stage_profiler::clock_name() << "\n\n";
+  for (const std::string_view name : {"asmeninis", "ai"}) {
+    HasherRegistry::visit(name, [&](const auto &hasher) {
+      Timer t;
+      std::size_t sink = 0;
+      for (const auto &input : inputs) {
+        sink += static_cast<unsigned char>(hasher.hash256bit(input)[0]);
+      }
+      std::cout << name << ": " << std::fixed << std::setprecision(0)
+                << static_cast<double>(count) / t.elapsed() << " hashes/s"
+                << (sink == 0 ? " " : "") << '\n';
+    });
+  }
+  std::cout << '\n';
+
+  const auto totals = stage_profiler::report();
+  if (json) {
+    stage_profiler::write_json(std::cout, totals);
+  } else {
+    stage_profiler::write_table(std::cout, totals);
+  }
+  return 0;
+}
\ No newline at end of file
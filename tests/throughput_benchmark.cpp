@@ -0,0 +1,411 @@
+#include "benchmark_modes.h"
+#include "throughput_sweep.h"
+#include <constants.h>
+#include <crypto/hasher_registry.h>
+#include <Timer.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <thread_pool.h>
+#include <tuple>
+#include <type_traits>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr double kMaxCallSeconds = 2.0;
+constexpr std::uint64_t kHotRepetitionNs = 20000000;
+constexpr int kHotRepetitions = 5;
+constexpr int kColdRepetitions = 15;
+// Larger than any last-level cache we run on.
+constexpr std::size_t kScrubBytes = std::size_t{128} << 20U;
+
+// Working memory on top of the input. Only AIHasher's parallel absorb grows
+// with the input: it keeps a rolling word per byte, and it runs only from
+// 2048 bytes (kParallelThreshold in AIHasher.cpp) with more than one thread.
+// The asmeninis collapse works on a fixed 64-byte block.
+double extra_bytes(std::string_view hasher, unsigned cap, std::size_t size) {
+  if (hasher == "ai" && cap > 1 && size >= 2048) {
+    return 4.0 * static_cast<double>(size);
+  }
+  return 0.0;
+}
+
+std::size_t physical_memory() {
+#if defined(__unix__) || defined(__APPLE__)
+  const long pages = sysconf(_SC_PHYS_PAGES);
+  const long page_size = sysconf(_SC_PAGE_SIZE);
+  if (pages > 0 && page_size > 0) {
+    return static_cast<std::size_t>(pages) * static_cast<std::size_t>(page_size);
+  }
+#endif
+  return std::numeric_limits<std::size_t>::max();
+}
+
+std::string read_konstitucija() {
+  std::ifstream stream(kKonstitucijaPath, std::ios::binary);
+  std::string text(std::istreambuf_iterator<char>(stream), {});
+  if (text.empty()) {
+    throw std::runtime_error("konstitucija file is missing or empty");
+  }
+  return text;
+}
+
+std::string make_input(std::size_t size, const std::string &text) {
+  std::string input(size, '\0');
+  if (!text.empty()) {
+    for (std::size_t at = 0; at < size; at += text.size()) {
+      input.replace(at, std::min(text.size(), size - at), text, 0,
+                    std::min(text.size(), size - at));
+    }
+    return input;
+  }
+  std::uint64_t state = 0x9E3779B97F4A7C15ULL;
+  for (char &c : input) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    c = static_cast<char>(state >> 56U);
+  }
+  return input;
+}
+
+// Reads a buffer larger than the caches so the next call starts cold.
+void scrub_caches(const std::vector<char> &scrub) {
+  std::size_t sum = 0;
+  for (std::size_t i = 0; i < scrub.size(); i += 64) {
+    sum += static_cast<unsigned char>(scrub[i]);
+  }
+  volatile std::size_t keep = sum;
+  (void)keep;
+}
+
+struct Measurement {
+  double seconds_per_call = 0.0;
+  double slowest_call = 0.0;
+  std::optional<PerfSample> counters;
+  std::size_t bytes_counted = 0;
+  // Pool workers ran part of the hashing, which the counters do not see.
+  bool offloaded = false;
+};
+
+template <ConcreteHasher H>
+Measurement measure(const H &hasher, const std::string &input, bool cold,
+                    PerfCounters *counters, const std::vector<char> &scrub) {
+  Measurement m;
+  std::size_t sink = 0;
+  std::vector<double> samples;
+  const ThreadPool &pool = ThreadPool::global();
+  auto timed_batch = [&](std::uint64_t calls) {
+    const std::uint64_t worker_tasks = pool.worker_tasks();
+    if (counters) {
+      counters->start();
+    }
+    Timer t;
+    for (std::uint64_t i = 0; i < calls; ++i) {
+      sink += static_cast<unsigned char>(hasher.hash256bit(input)[0]);
+    }
+    const double seconds = t.elapsed();
+    if (counters) {
+      const PerfSample sample = counters->stop();
+      if (m.counters) {
+        *m.counters += sample;
+      } else {
+        m.counters = sample;
+      }
+      m.bytes_counted += static_cast<std::size_t>(calls) * input.size();
+    }
+    m.offloaded = m.offloaded || pool.worker_tasks() != worker_tasks;
+    m.slowest_call = std::max(m.slowest_call, seconds / static_cast<double>(calls));
+    samples.push_back(seconds / static_cast<double>(calls));
+  };
+
+  if (cold) {
+    for (int r = 0; r < kColdRepetitions && m.slowest_call < kMaxCallSeconds; ++r) {
+      scrub_caches(scrub);
+      timed_batch(1);
+    }
+  } else {
+    Timer warm;
+    sink += static_cast<unsigned char>(hasher.hash256bit(input)[0]);
+    const std::uint64_t once = std::max<std::uint64_t>(1, warm.elapsed_ns());
+    m.slowest_call = static_cast<double>(once) * 1e-9;
+    const std::uint64_t calls = std::max<std::uint64_t>(1, kHotRepetitionNs / once);
+    for (int r = 0; r < kHotRepetitions && m.slowest_call < kMaxCallSeconds; ++r) {
+      timed_batch(calls);
+    }
+  }
+
+  volatile std::size_t keep = sink;
+  (void)keep;
+  std::nth_element(samples.begin(), samples.begin() + static_cast<std::ptrdiff_t>(samples.size() / 2),
+                   samples.end());
+  m.seconds_per_call = samples[samples.size() / 2];
+  if (m.offloaded) {
+    m.counters.reset();
+  }
+  return m;
+}
+
+std::string column_name(const SweepPoint &p, bool with_threads) {
+  return with_threads ? p.hasher + "@" + std::to_string(p.threads) : p.hasher;
+}
+
+std::size_t parse_size(std::string_view text) {
+  std::size_t used = 0;
+  std::size_t value = std::stoull(std::string(text), &used);
+  switch (used < text.size() ? text[used] : '\0') {
+  case 'G':
+  case 'g':
+    value <<= 10U;
+    [[fallthrough]];
+  case 'M':
+  case 'm':
+    value <<= 10U;
+    [[fallthrough]];
+  case 'K':
+  case 'k':
+    value <<= 10U;
+    break;
+  default:
+    break;
+  }
+  return value;
+}
+
+std::vector<unsigned> parse_threads(std::string_view text) {
+  std::vector<unsigned> threads;
+  std::istringstream stream{std::string(text)};
+  for (std::string item; std::getline(stream, item, ',');) {
+    threads.push_back(static_cast<unsigned>(std::stoul(item)));
+  }
+  return threads;
+}
+
+} // namespace
+
+std::vector<SweepPoint> throughput_sweep(const SweepOptions &options,
+                                         PerfCounters *counters) {
+  const std::string text = options.text ? read_konstitucija() : std::string();
+  const std::vector<char> scrub(options.cold ? kScrubBytes : 0, 1);
+  const std::size_t memory_budget = physical_memory() / 2;
+
+  std::vector<std::string> names = options.hashers;
+  if (names.empty()) {
+    for (const std::string_view name : HasherRegistry::names()) {
+      names.emplace_back(name);
+    }
+  }
+
+  std::vector<std::size_t> sizes;
+  for (std::size_t size = 1; size <= options.max_bytes; size *= 4) {
+    sizes.push_back(size);
+    if (size > options.max_bytes / 4) {
+      break;
+    }
+  }
+
+  // Sizes outer, so one input buffer at a time is alive; a hasher that hit
+  // a limit is not run at larger sizes. The buffer is built for the first
+  // hasher that fits the memory budget, so a size every hasher skips is
+  // never allocated.
+  std::map<std::pair<std::string, unsigned>, bool> stopped;
+  std::vector<SweepPoint> points;
+  for (const std::size_t size : sizes) {
+    std::string input;
+    bool built = false;
+    for (const std::string &name : names) {
+      HasherRegistry::visit(name, [&](const auto &prototype) {
+        using H = std::remove_cvref_t<decltype(prototype)>;
+        // Caps above the pool size run the same as the pool, so are dropped.
+        std::vector<unsigned> caps = {1};
+        if constexpr (std::is_constructible_v<H, unsigned>) {
+          const auto pool = static_cast<unsigned>(ThreadPool::global().size());
+          caps.clear();
+          for (const unsigned cap : options.threads.empty() ? std::vector<unsigned>{0}
+                                                            : options.threads) {
+            const unsigned effective = cap == 0 ? pool : std::min(cap, pool);
+            if (std::find(caps.begin(), caps.end(), effective) == caps.end()) {
+              caps.push_back(effective);
+            }
+          }
+        }
+        for (const unsigned cap : caps) {
+          bool &done = stopped[{name, cap}];
+          if (done) {
+            continue;
+          }
+          if (static_cast<double>(size) + extra_bytes(name, cap, size) >
+              static_cast<double>(memory_budget)) {
+            std::cerr << name << ": skipping " << size
+                      << " B and up, working memory would exceed half of RAM\n";
+            done = true;
+            continue;
+          }
+          const H hasher = [&]() {
+            if constexpr (std::is_constructible_v<H, unsigned>) {
+              return H(cap);
+            } else {
+              return H{};
+            }
+          }();
+          if (!built) {
+            input = make_input(size, text);
+            built = true;
+          }
+          const Measurement m = measure(hasher, input, options.cold, counters, scrub);
+          SweepPoint point;
+          point.hasher = name;
+          point.bytes = size;
+          point.threads = cap;
+          point.seconds_per_call = m.seconds_per_call;
+          point.gb_per_s = static_cast<double>(size) / m.seconds_per_call * 1e-9;
+          point.counters = m.counters.value_or(PerfSample{});
+          point.bytes_counted = m.bytes_counted;
+          points.push_back(std::move(point));
+          done = m.slowest_call >= kMaxCallSeconds;
+        }
+      });
+    }
+  }
+
+  std::stable_sort(points.begin(), points.end(), [](const SweepPoint &a, const SweepPoint &b) {
+    return std::tie(a.hasher, a.threads) < std::tie(b.hasher, b.threads);
+  });
+  return points;
+}
+
+void print_sweep_md_table(const std::vector<SweepPoint> &points, std::ostream &os) {
+  const bool with_counters = std::any_of(points.begin(), points.end(), [](const SweepPoint &p) {
+    return std::any_of(p.counters.values.begin(), p.counters.values.end(),
+                       [](const auto &v) { return v.has_value(); });
+  });
+  os << "| Hasher | Threads | Bytes | GB/s | ns/call |";
+  if (with_counters) {
+    os << " IPC | Cycles/B | Instr/B | Br miss/KiB | L1d miss/KiB | LLC miss/KiB |";
+  }
+  os << "\n| :----- | ------: | ----: | ---: | ------: |";
+  if (with_counters) {
+    os << " --: | -------: | ------: | ----------: | -----------: | -----------: |";
+  }
+  os << '\n';
+
+  const auto flags = os.flags();
+  const auto precision = os.precision();
+  os.setf(std::ios::fixed, std::ios::floatfield);
+  auto cell = [&](std::optional<double> value, double scale) {
+    if (value) {
+      os << ' ' << std::setprecision(2) << *value * scale << " |";
+    } else {
+      os << " - |";
+    }
+  };
+  for (const SweepPoint &p : points) {
+    os << "| " << p.hasher << " | " << p.threads << " | " << p.bytes << " | "
+       << std::setprecision(3) << p.gb_per_s << " | " << std::setprecision(0)
+       << p.seconds_per_call * 1e9 << " |";
+    if (with_counters) {
+      cell(p.counters.ipc(), 1.0);
+      cell(p.counters.per_byte(PerfEvent::cycles, p.bytes_counted), 1.0);
+      cell(p.counters.per_byte(PerfEvent::instructions, p.bytes_counted), 1.0);
+      cell(p.counters.per_byte(PerfEvent::branch_misses, p.bytes_counted), 1024.0);
+      cell(p.counters.per_byte(PerfEvent::l1d_misses, p.bytes_counted), 1024.0);
+      cell(p.counters.per_byte(PerfEvent::llc_misses, p.bytes_counted), 1024.0);
+    }
+    os << '\n';
+  }
+  os.flags(flags);
+  os.precision(precision);
+}
+
+void write_sweep_chart_data(const std::vector<SweepPoint> &points,
+                            const std::filesystem::path &path) {
+  std::map<std::string, std::vector<unsigned>> seen;
+  for (const SweepPoint &p : points) {
+    auto &list = seen[p.hasher];
+    if (std::find(list.begin(), list.end(), p.threads) == list.end()) {
+      list.push_back(p.threads);
+    }
+  }
+  std::vector<std::string> columns;
+  std::map<std::size_t, std::map<std::string, double>> rows;
+  for (const SweepPoint &p : points) {
+    const std::string column = column_name(p, seen[p.hasher].size() > 1);
+    if (std::find(columns.begin(), columns.end(), column) == columns.end()) {
+      columns.push_back(column);
+    }
+    rows[p.bytes][column] = p.gb_per_s;
+  }
+
+  if (path.has_parent_path()) {
+    std::filesystem::create_directories(path.parent_path());
+  }
+  std::ofstream stream(path, std::ios::trunc);
+  if (!stream) {
+    throw std::runtime_error("failed to open output file '" + path.string() + "'");
+  }
+  stream << "Bytes";
+  for (const std::string &column : columns) {
+    stream << ' ' << column;
+  }
+  stream << '\n' << std::setprecision(6);
+  for (const auto &[bytes, values] : rows) {
+    stream << bytes;
+    for (const std::string &column : columns) {
+      const auto it = values.find(column);
+      stream << ' ';
+      if (it == values.end()) {
+        stream << "nan";
+      } else {
+        stream << it->second;
+      }
+    }
+    stream << '\n';
+  }
+}
+
+// GB/s of every hasher from 1 B up. Arguments: largest size (K/M/G suffix,
+// default 64M), "random" or "text" data, "hot" or "cold" caches, and a
+// comma-separated list of worker caps for the parallel hashers.
+int benchmark_throughput(int argc, char *argv[]) {
+  SweepOptions options;
+  try {
+    if (argc > 2) {
+      options.max_bytes = parse_size(argv[2]);
+    }
+    options.text = argc > 3 && std::string_view(argv[3]) == "text";
+    options.cold = argc > 4 && std::string_view(argv[4]) == "cold";
+    if (argc > 5) {
+      options.threads = parse_threads(argv[5]);
+    }
+  } catch (const std::exception &e) {
+    std::cerr << "bad argument: " << e.what() << '\n';
+    return 1;
+  }
+
+  PerfCounters counters;
+  std::cout << "sizes 1 B to " << options.max_bytes << " B, "
+            << (options.text ? "konstitucija text" : "random data") << ", "
+            << (options.cold ? "cold" : "hot") << " caches, pool of "
+            << ThreadPool::global().size() << " thread(s)\n\n";
+  try {
+    const auto points = throughput_sweep(options, counters.available() ? &counters : nullptr);
+    print_sweep_md_table(points, std::cout);
+    write_sweep_chart_data(points, kResultsPath / "throughput.txt");
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << '\n';
+    return 1;
+  }
+  return 0;
+}
\ No newline at end of file
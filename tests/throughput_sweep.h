@@ -0,0 +1,48 @@
+#pragma once
+#include <perf_counters.h>
+#include <cstddef>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct SweepOptions {
+  // Sizes run 1, 4, 16, ... bytes up to and including max_bytes.
+  std::size_t max_bytes = std::size_t{64} << 20U;
+  // konstitucija.txt repeated to size instead of pseudo-random bytes.
+  bool text = false;
+  // Evict the caches before every timed call.
+  bool cold = false;
+  // Worker caps for hashers constructible from a thread count; empty means
+  // the whole pool. Other hashers run once.
+  std::vector<unsigned> threads;
+  // Registered hasher names; empty means all of them.
+  std::vector<std::string> hashers;
+};
+
+struct SweepPoint {
+  std::string hasher;
+  std::size_t bytes = 0;
+  unsigned threads = 0;
+  // Median over the repetitions.
+  double seconds_per_call = 0.0;
+  double gb_per_s = 0.0;
+  // Summed over every timed call; bytes_counted is what they hashed. Left
+  // empty when pool workers did part of the hashing, since only the
+  // calling thread is counted.
+  PerfSample counters;
+  std::size_t bytes_counted = 0;
+};
+
+// Throughput of each hasher over the size range. A hasher stops at the
+// first size where one call took over 2 s, or where its working memory
+// would not fit in half of physical RAM.
+[[nodiscard]] std::vector<SweepPoint> throughput_sweep(const SweepOptions &options,
+                                                       PerfCounters *counters = nullptr);
+
+void print_sweep_md_table(const std::vector<SweepPoint> &points,
+                          std::ostream &os = std::cout);
+// Whitespace-separated "Bytes <hasher>..." GB/s columns for
+// draw_konstitucija_chart.py; nan where a hasher skipped a size.
+void write_sweep_chart_data(const std::vector<SweepPoint> &points,
+                            const std::filesystem::path &path);
\ No newline at end of file
@@ -0,0 +1,53 @@
+#include "benchmark_modes.h"
+#include <Timer.h>
+#include <crypto/AITreeHasher.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+int benchmark_tree_hashing(int argc, char *argv[]) {
+  const std::size_t mib =
+      argc > 2 ? static_cast<std::size_t>(std::stoull(argv[2])) : 2048U;
+  const unsigned max_threads =
+      argc > 3 ? static_cast<unsigned>(std::stoul(argv[3]))
+               : std::max(32u, std::thread::hardware_concurrency());
+
+  std::cout << "generating " << mib << " MiB input..\n";
+  std::string input(mib * 1024U * 1024U, '\0');
+  std::uint64_t state = 0x243F6A8885A308D3ULL;
+  for (std::size_t i = 0; i + 8 <= input.size(); i += 8) {
+    state ^= state << 13U;
+    state ^= state >> 7U;
+    state ^= state << 17U;
+    for (std::size_t b = 0; b < 8; ++b) {
+      input[i + b] = static_cast<char>(state >> (b * 8U));
+    }
+  }
+
+  std::cout << "hardware threads: " << std::thread::hardware_concurrency()
+            << "\n\n";
+  std::cout << "| Threads | Time (s) | GB/s | Speedup |\n";
+  std::cout << "| ------: | -------: | ---: | ------: |\n";
+  double baseline = 0.0;
+  for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+    const AITreeHasher tree(threads);
+    Timer t;
+    const auto digest = tree.digest(input);
+    const double elapsed = t.elapsed();
+    if (threads == 1) {
+      baseline = elapsed;
+    }
+    volatile std::uint8_t sink = digest[0];
+    (void)sink;
+    std::cout << std::fixed << std::setprecision(4) << "| " << threads << " | "
+              << elapsed << " | "
+              << static_cast<double>(input.size()) / elapsed / 1e9 << " | "
+              << std::setprecision(2) << baseline / elapsed << " |\n";
+  }
+  return 0;
+}
\ No newline at end of file